@@ -1,9 +1,10 @@
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 
+#include "bench.hpp"
 #include "conv.hpp"
 #include "generator.hpp"
-#include "timer.hpp"
 
 int
 main(int argc, char* argv[])
@@ -31,11 +32,23 @@ main(int argc, char* argv[])
     cmpe492::random_fill(inp.begin(), inp.end());
     cmpe492::random_fill(win.begin(), win.end());
 
-    std::cout << "running time:\t" << std::flush;
-    {
-        cmpe492::timer t{ std::cout };
-        cmpe492::conv(n1, n2, nw, inp.data(), win.data(), res.data());
-    }
+    // opened before the first call, which starts the thread pool, so that its workers are counted
+    cmpe492::perf_counters counters;
+
+    const auto st = cmpe492::bench_run(
+      [&] { cmpe492::conv(n1, n2, nw, inp.data(), win.data(), res.data()); },
+      cmpe492::bench_options::from_env(),
+      &counters);
+
+    // the direct algorithm, whatever the kernel does. the input is read and the result written
+    // once at least.
+    cmpe492::bench_report(std::cout,
+                          "conv",
+                          { n1, n2, nw },
+                          st,
+                          2.0 * n1 * n2 * nw * nw,
+                          4.0 * (2.0 * n1 * n2 + nw * nw),
+                          &counters);
 
     std::cout << "========" << std::endl;
 
@@ -0,0 +1,55 @@
+#include <array>
+#include <vector>
+
+#include "bench_driver.hpp"
+#include "conv.hpp"
+#include "generator.hpp"
+
+// bench-conv, the variants of conv() registered with util/registry.hpp run in turn on the same
+// input and window. each result is compared with the one of the first variant.
+
+namespace {
+
+struct conv_task
+{
+    using fn = cmpe492::conv_fn;
+    using shape_t = std::array<int, 3>;
+
+    static constexpr char const* name = "conv";
+    static constexpr char const* shape_names = "n1 n2 nw";
+    static constexpr shape_t default_shape = { 4000, 4000, 15 };
+
+    // the direct algorithm, whatever the kernel does
+    static double flops(shape_t s) { return 2.0 * s[0] * s[1] * s[2] * s[2]; }
+
+    // the input is read and the result written once at least
+    static double bytes(shape_t s) { return 4.0 * (2.0 * s[0] * s[1] + s[2] * s[2]); }
+
+    struct operands
+    {
+        int n1, n2, nw;
+        std::vector<float> inp, win, res;
+
+        explicit operands(shape_t s)
+          : n1(s[0])
+          , n2(s[1])
+          , nw(s[2])
+          , inp(n1 * n2)
+          , win(nw * nw)
+          , res(n1 * n2)
+        {
+            cmpe492::random_fill(inp.begin(), inp.end());
+            cmpe492::random_fill(win.begin(), win.end());
+        }
+
+        void call(fn* kernel) { kernel(n1, n2, nw, inp.data(), win.data(), res.data()); }
+    };
+};
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    return cmpe492::bench_driver<conv_task>(argc, argv);
+}
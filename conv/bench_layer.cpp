@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "bench.hpp"
+#include "conv.hpp"
+#include "conv_layer.hpp"
+#include "generator.hpp"
+
+/// compares conv_layer() with a loop of conv() over the pairs of input and output channels
+int
+main(int argc, char* argv[])
+{
+    int n = 8, c_in = 64, c_out = 64, h = 56, w = 56, nw = 3;
+
+    if (argc == 7) {
+        n = std::atoi(argv[1]);
+        c_in = std::atoi(argv[2]);
+        c_out = std::atoi(argv[3]);
+        h = std::atoi(argv[4]);
+        w = std::atoi(argv[5]);
+        nw = std::atoi(argv[6]);
+    } else if (argc != 1) {
+        std::cout << "usage: " << argv[0] << " [n c_in c_out h w nw]" << std::endl;
+        return 1;
+    }
+
+    std::cout << n << " " << c_in << " " << c_out << " " << h << " " << w << " " << nw
+              << std::endl;
+
+    const int hw_sz = h * w;
+
+    std::vector<float> inp(n * c_in * hw_sz);
+    std::vector<float> filters(c_out * c_in * nw * nw);
+    std::vector<float> res(n * c_out * hw_sz);
+
+    cmpe492::random_fill(inp.begin(), inp.end());
+    cmpe492::random_fill(filters.begin(), filters.end());
+
+    std::vector<float> tmp(hw_sz);
+
+    auto conv_loop = [&] {
+        for (int b = 0; b < n; b++) {
+            for (int co = 0; co < c_out; co++) {
+                float* const out = &res[(b * c_out + co) * hw_sz];
+                std::fill(out, out + hw_sz, 0.0f);
+
+                for (int ci = 0; ci < c_in; ci++) {
+                    cmpe492::conv(h,
+                                  w,
+                                  nw,
+                                  &inp[(b * c_in + ci) * hw_sz],
+                                  &filters[(co * c_in + ci) * nw * nw],
+                                  tmp.data());
+
+                    for (int k = 0; k < hw_sz; k++) {
+                        out[k] += tmp[k];
+                    }
+                }
+            }
+        }
+    };
+
+    auto layer = [&] {
+        cmpe492::conv_layer(n, c_in, c_out, h, w, nw, inp.data(), filters.data(), res.data());
+    };
+
+    const auto st = cmpe492::bench_run_interleaved({ conv_loop, layer });
+
+    // the direct algorithm. the input, the filters and the result are moved once at least.
+    cmpe492::bench_report_baseline(std::cout, "conv loop", st[0], st[1]);
+    cmpe492::bench_report(std::cout,
+                          "conv_layer",
+                          { n, c_in, c_out, h, w, nw },
+                          st[1],
+                          2.0 * n * c_in * c_out * hw_sz * nw * nw,
+                          4.0 * (double(n) * (c_in + c_out) * hw_sz + c_out * c_in * nw * nw));
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
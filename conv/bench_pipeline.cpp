@@ -0,0 +1,83 @@
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "bench.hpp"
+#include "conv.hpp"
+#include "generator.hpp"
+
+/// compares conv_pipeline() with a conv() per stage, which stores every intermediate result.
+/// the sides of the windows of the stages follow n1 and n2 on the command line.
+int
+main(int argc, char* argv[])
+{
+    int n1 = 4000, n2 = 4000;
+    std::vector<int> nws = { 5, 3, 3 };
+
+    if (argc >= 4) {
+        n1 = std::atoi(argv[1]);
+        n2 = std::atoi(argv[2]);
+        nws.clear();
+        for (int k = 3; k < argc; k++) {
+            nws.push_back(std::atoi(argv[k]));
+        }
+    } else if (argc != 1) {
+        std::cout << "usage: " << argv[0] << " [n1 n2 nw...]" << std::endl;
+        return 1;
+    }
+
+    const int n_stages = nws.size();
+
+    std::cout << n1 << " " << n2;
+    for (int nw : nws) {
+        std::cout << " " << nw;
+    }
+    std::cout << std::endl;
+
+    std::vector<float> inp(n1 * n2);
+    std::vector<float> res(n1 * n2), tmp(n1 * n2);
+    std::vector<std::vector<float>> wins(n_stages);
+    std::vector<float const*> win_ptrs(n_stages);
+
+    cmpe492::random_fill(inp.begin(), inp.end());
+
+    for (int s = 0; s < n_stages; s++) {
+        wins[s].resize(nws[s] * nws[s]);
+        cmpe492::random_fill(wins[s].begin(), wins[s].end());
+        win_ptrs[s] = wins[s].data();
+    }
+
+    auto per_stage = [&] {
+        float const* in = inp.data();
+        for (int s = 0; s < n_stages; s++) {
+            cmpe492::conv(n1, n2, nws[s], in, wins[s].data(), res.data());
+            std::swap(res, tmp);
+            in = tmp.data();
+        }
+    };
+
+    auto pipeline = [&] {
+        cmpe492::conv_pipeline(
+          n1, n2, n_stages, nws.data(), win_ptrs.data(), inp.data(), res.data());
+    };
+
+    // in rounds, so that neither pays alone for the start of the thread pool or a slower phase of
+    // the machine
+    const auto st = cmpe492::bench_run_interleaved({ per_stage, pipeline });
+
+    // the direct algorithm of every stage. the input is read and the result written once at least.
+    double flops = 0;
+    std::vector<long> shape = { n1, n2 };
+    for (int nw : nws) {
+        flops += 2.0 * n1 * n2 * nw * nw;
+        shape.push_back(nw);
+    }
+
+    cmpe492::bench_report_baseline(std::cout, "conv per stage", st[0], st[1]);
+    cmpe492::bench_report(std::cout, "conv_pipeline", shape, st[1], flops, 8.0 * n1 * n2);
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <iostream>
+#include <vector>
+
+#include "bench.hpp"
+#include "conv.hpp"
+#include "generator.hpp"
+
+/// compares the direct convolution with a general window against the separable path,
+/// taken by conv() for a rank-1 window and by conv_separable() for explicit factors
+int
+main(int argc, char* argv[])
+{
+    int n1, n2;
+
+    if (argc == 1) {
+        n1 = n2 = 4000;
+    } else if (argc == 3) {
+        n1 = std::atoi(argv[1]);
+        n2 = std::atoi(argv[2]);
+    } else {
+        std::cout << "usage: " << argv[0] << " [n1 n2]" << std::endl;
+        return 1;
+    }
+
+    std::vector<float> inp(n1 * n2);
+    std::vector<float> res(n1 * n2);
+
+    cmpe492::random_fill(inp.begin(), inp.end());
+
+    for (int nw : { 15, 31 }) {
+        std::vector<float> win(nw * nw);
+        std::vector<float> col(nw), row(nw);
+
+        cmpe492::random_fill(win.begin(), win.end());
+        cmpe492::random_fill(col.begin(), col.end());
+        cmpe492::random_fill(row.begin(), row.end());
+
+        std::vector<float> sep_win(nw * nw);
+        for (int k1 = 0; k1 < nw; k1++) {
+            for (int k2 = 0; k2 < nw; k2++) {
+                sep_win[k1 * nw + k2] = col[k1] * row[k2];
+            }
+        }
+
+        std::cout << n1 << " " << n2 << " " << nw << std::endl;
+
+        const auto st = cmpe492::bench_run_interleaved({
+          [&] { cmpe492::conv(n1, n2, nw, inp.data(), win.data(), res.data()); },
+          [&] { cmpe492::conv(n1, n2, nw, inp.data(), sep_win.data(), res.data()); },
+          [&] {
+              cmpe492::conv_separable(n1, n2, nw, inp.data(), col.data(), row.data(), res.data());
+          },
+        });
+
+        // the direct algorithm, like bench-conv_simd_mt, for the three
+        cmpe492::bench_report_baseline(std::cout, "direct", st[0], st[2]);
+        cmpe492::bench_report_baseline(std::cout, "rank-1 window", st[1], st[2]);
+        cmpe492::bench_report(std::cout,
+                              "conv_separable",
+                              { n1, n2, nw },
+                              st[2],
+                              2.0 * n1 * n2 * nw * nw,
+                              4.0 * (2.0 * n1 * n2 + nw * nw));
+    }
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "bench.hpp"
+#include "conv.hpp"
+#include "conv_stream.hpp"
+#include "generator.hpp"
+
+/// compares conv() on a whole image with a conv_stream fed chunk rows at a time, whose memory
+/// does not grow with the height of the image
+int
+main(int argc, char* argv[])
+{
+    int n1 = 4000, n2 = 4000, nw = 7, chunk = 16;
+
+    if (argc == 5) {
+        n1 = std::atoi(argv[1]);
+        n2 = std::atoi(argv[2]);
+        nw = std::atoi(argv[3]);
+        chunk = std::atoi(argv[4]);
+    } else if (argc != 1) {
+        std::cout << "usage: " << argv[0] << " [n1 n2 nw chunk]" << std::endl;
+        return 1;
+    }
+
+    std::cout << n1 << " " << n2 << " " << nw << " " << chunk << std::endl;
+
+    std::vector<float> inp(n1 * n2);
+    std::vector<float> win(nw * nw);
+    std::vector<float> res(n1 * n2);
+
+    cmpe492::random_fill(inp.begin(), inp.end());
+    cmpe492::random_fill(win.begin(), win.end());
+
+    auto whole = [&] { cmpe492::conv(n1, n2, nw, inp.data(), win.data(), res.data()); };
+
+    auto streamed = [&] {
+        cmpe492::conv_stream stream(n2, nw, win.data());
+
+        int written = 0;
+        for (int i = 0; i < n1; i += chunk) {
+            const int rows = std::min(chunk, n1 - i);
+            written += stream.push(rows, &inp[i * n2], &res[written * n2]);
+        }
+        stream.finish(&res[written * n2]);
+    };
+
+    const auto st = cmpe492::bench_run_interleaved({ whole, streamed });
+
+    // like bench-conv_simd_mt, the input is read and the result written once at least
+    cmpe492::bench_report_baseline(std::cout, "conv", st[0], st[1]);
+    cmpe492::bench_report(std::cout,
+                          "conv_stream",
+                          { n1, n2, nw, chunk },
+                          st[1],
+                          2.0 * n1 * n2 * nw * nw,
+                          4.0 * (2.0 * n1 * n2 + nw * nw));
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "bench.hpp"
+#include "conv.hpp"
+#include "generator.hpp"
+
+/// compares conv_strided() with conv() at full resolution followed by subsampling, which computes
+/// s1 * s2 times as many results as are kept
+int
+main(int argc, char* argv[])
+{
+    int n1 = 4000, n2 = 4000, nw = 7, s = 2, d = 1;
+
+    if (argc == 6) {
+        n1 = std::atoi(argv[1]);
+        n2 = std::atoi(argv[2]);
+        nw = std::atoi(argv[3]);
+        s = std::atoi(argv[4]);
+        d = std::atoi(argv[5]);
+    } else if (argc != 1) {
+        std::cout << "usage: " << argv[0] << " [n1 n2 nw stride dilation]" << std::endl;
+        return 1;
+    }
+
+    std::cout << n1 << " " << n2 << " " << nw << " " << s << " " << d << std::endl;
+
+    const int nd = (nw - 1) * d + 1;
+    const int m1 = (n1 + s - 1) / s;
+    const int m2 = (n2 + s - 1) / s;
+
+    std::vector<float> inp(n1 * n2);
+    std::vector<float> win(nw * nw);
+    std::vector<float> dilated(nd * nd, 0.0f);
+    std::vector<float> full(n1 * n2);
+    std::vector<float> res(m1 * m2);
+
+    cmpe492::random_fill(inp.begin(), inp.end());
+    cmpe492::random_fill(win.begin(), win.end());
+
+    for (int k1 = 0; k1 < nw; k1++) {
+        for (int k2 = 0; k2 < nw; k2++) {
+            dilated[k1 * d * nd + k2 * d] = win[k1 * nw + k2];
+        }
+    }
+
+    auto subsampled = [&] {
+        cmpe492::conv(n1, n2, nd, inp.data(), dilated.data(), full.data());
+
+        for (int i = 0; i < m1; i++) {
+            for (int j = 0; j < m2; j++) {
+                res[i * m2 + j] = full[i * s * n2 + j * s];
+            }
+        }
+    };
+
+    auto strided = [&] {
+        cmpe492::conv_strided(n1, n2, nw, s, s, d, d, inp.data(), win.data(), res.data());
+    };
+
+    const auto st = cmpe492::bench_run_interleaved({ subsampled, strided });
+
+    // the kept results only. the input is read and the result written once at least.
+    cmpe492::bench_report_baseline(std::cout, "conv and subsample", st[0], st[1]);
+    cmpe492::bench_report(std::cout,
+                          "conv_strided",
+                          { n1, n2, nw, s, d },
+                          st[1],
+                          2.0 * m1 * m2 * nw * nw,
+                          4.0 * (double(n1) * n2 + double(m1) * m2 + nw * nw));
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "bench.hpp"
+#include "conv.hpp"
+#include "generator.hpp"
+
+/// sweeps the width of the input at a fixed number of elements, so that the time per element
+/// shows where the rows that a result row needs stop fitting in the caches
+int
+main(int argc, char* argv[])
+{
+    int nw = 7;
+    long elements = 1L << 24;
+
+    if (argc == 2 || argc == 3) {
+        nw = std::atoi(argv[1]);
+
+        if (argc == 3) {
+            elements = std::atol(argv[2]);
+        }
+    } else if (argc != 1) {
+        std::cout << "usage: " << argv[0] << " [nw [elements]]" << std::endl;
+        return 1;
+    }
+
+    std::vector<float> inp(elements);
+    std::vector<float> win(nw * nw);
+    std::vector<float> res(elements);
+
+    cmpe492::random_fill(inp.begin(), inp.end());
+    cmpe492::random_fill(win.begin(), win.end());
+
+    std::cout << "nw " << nw << ", " << elements << " elements" << std::endl;
+    std::cout << "n1\tn2\tmedian (s)\tns/element\tGFLOP/s" << std::endl;
+
+    for (long n2 = 256; n2 <= elements / 128; n2 *= 4) {
+        const int n1 = static_cast<int>(elements / n2);
+
+        const double t =
+          cmpe492::bench_run([&] { cmpe492::conv(n1, n2, nw, inp.data(), win.data(), res.data()); })
+            .median;
+        const double n = static_cast<double>(n1) * n2;
+
+        std::cout << std::setprecision(4) << std::fixed << n1 << "\t" << n2 << "\t" << t << "\t"
+                  << t / n * 1e9 << "\t" << 2.0 * nw * nw * n / t * 1e-9 << std::endl;
+    }
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
@@ -5,4 +5,60 @@ namespace cmpe492 {
 void
 conv(const int n1, const int n2, const int nw, float const* inp, float const* win, float* res);
 
-} // namespace cmpe492
\ No newline at end of file
+/// the type of conv(), which the variants built for bench-conv register (see util/registry.hpp)
+using conv_fn = void(int n1, int n2, int nw, float const* inp, float const* win, float* res);
+
+/// convolve matrix inp with the separable window col * row^T, the nw by nw window whose element
+/// (k1, k2) is col[k1] * row[k2], in two 1d passes. the arguments are as in conv().
+/// conv() also takes this path when its window has rank 1.
+/// only the conv_simd_mt and conv_dispatch builds provide it.
+void
+conv_separable(const int n1,
+               const int n2,
+               const int nw,
+               float const* inp,
+               float const* col,
+               float const* row,
+               float* res);
+
+/// convolve matrix inp with win dilated by (d1, d2), at every s1-th row and s2-th column only.
+/// the result (i, j) is the sum over the window of win[k1][k2] times the input element
+/// (i * s1 + d1 * (k1 - nw / 2), j * s2 + d2 * (k2 - nw / 2)), with the elements out of inp
+/// taken as 0. that is the result (i * s1, j * s2) of conv() with the dilated window, whose
+/// elements between those of win are 0.
+/// inp is n1 by n2, res is (n1 + s1 - 1) / s1 by (n2 + s2 - 1) / s2, nw is odd.
+/// only the conv_simd_mt and conv_dispatch builds provide it.
+void
+conv_strided(const int n1,
+             const int n2,
+             const int nw,
+             const int s1,
+             const int s2,
+             const int d1,
+             const int d2,
+             float const* inp,
+             float const* win,
+             float* res);
+
+/// convolve matrix inp with the windows of n_stages stages in turn, like n_stages calls of conv()
+/// that each take the result of the previous one as their input, but without storing those
+/// results: the stages are done tile by tile, with the tiles and the halos they need kept in the
+/// cache. stage s has the window wins[s], nws[s] by nws[s], nws[s] is odd.
+/// inp and res are n1 by n2.
+/// only the conv_simd_mt and conv_dispatch builds provide it.
+void
+conv_pipeline(const int n1,
+              const int n2,
+              const int n_stages,
+              int const* nws,
+              float const* const* wins,
+              float const* inp,
+              float* res);
+
+/// name of the instruction set ("sse", "avx2" or "avx512") of the kernel that is used.
+/// only the dispatching build (conv_dispatch) provides it, the kernel is chosen once on the first
+/// call according to the cpu and the CMPE492_ISA environment variable.
+char const*
+conv_isa();
+
+} // namespace cmpe492
@@ -1,9 +1,14 @@
 #include <cassert>
 
 #include "conv.hpp"
+#include "registry.hpp"
 
 namespace cmpe492 {
 
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
 void
 conv(int n1, int n2, int nw, float const* inp, float const* win, float* res)
 {
@@ -49,4 +54,10 @@ conv(int n1, int n2, int nw, float const* inp, float const* win, float* res)
     delete[] padded_inp;
 }
 
+CMPE492_REGISTER_KERNEL(conv_fn, conv);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
 } // namespace cmpe492
\ No newline at end of file
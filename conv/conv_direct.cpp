@@ -0,0 +1,38 @@
+#include <cassert>
+
+#include "conv.hpp"
+#include "direct_conv.hpp"
+#include "registry.hpp"
+#include "simd.hpp"
+
+#ifndef CMPE492_DIRECT_ROWS
+#define CMPE492_DIRECT_ROWS 4
+#endif
+#ifndef CMPE492_DIRECT_NV
+#define CMPE492_DIRECT_NV 2
+#endif
+
+namespace cmpe492 {
+
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
+void
+conv(const int n1, const int n2, const int nw, float const* inp, float const* win, float* res)
+{
+    assert(nw % 2 == 1);
+
+    const int num_thr = get_num_threads();
+
+    direct_conv<float8_t, CMPE492_DIRECT_ROWS, CMPE492_DIRECT_NV>(
+      n1, n2, nw, inp, win, res, (n1 + num_thr - 1) / num_thr);
+}
+
+CMPE492_REGISTER_KERNEL(conv_fn, conv);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
+} // namespace cmpe492
@@ -0,0 +1,284 @@
+#include "conv.hpp"
+#include "conv_tuning.hpp"
+#include "cpu.hpp"
+#include "registry.hpp"
+
+// conv_simd_mt.cpp is built once per instruction set, with a matching vector width, into the
+// namespaces below. conv() and the other functions of conv.hpp and conv_tuning.hpp forward each
+// call to the copy chosen on the first call.
+
+namespace cmpe492 {
+
+namespace isa_sse {
+void
+conv(const int n1, const int n2, const int nw, float const* inp, float const* win, float* res);
+
+void
+conv_separable(const int n1,
+               const int n2,
+               const int nw,
+               float const* inp,
+               float const* col,
+               float const* row,
+               float* res);
+
+void
+conv_strided(const int n1,
+             const int n2,
+             const int nw,
+             const int s1,
+             const int s2,
+             const int d1,
+             const int d2,
+             float const* inp,
+             float const* win,
+             float* res);
+
+void
+conv_pipeline(const int n1,
+              const int n2,
+              const int n_stages,
+              int const* nws,
+              float const* const* wins,
+              float const* inp,
+              float* res);
+
+conv_config
+conv_get_config(int n1, int n2, int nw);
+
+void
+conv_force_config(conv_config const* cfg);
+
+char const*
+conv_tuning_name();
+} // namespace isa_sse
+
+namespace isa_avx2 {
+void
+conv(const int n1, const int n2, const int nw, float const* inp, float const* win, float* res);
+
+void
+conv_separable(const int n1,
+               const int n2,
+               const int nw,
+               float const* inp,
+               float const* col,
+               float const* row,
+               float* res);
+
+void
+conv_strided(const int n1,
+             const int n2,
+             const int nw,
+             const int s1,
+             const int s2,
+             const int d1,
+             const int d2,
+             float const* inp,
+             float const* win,
+             float* res);
+
+void
+conv_pipeline(const int n1,
+              const int n2,
+              const int n_stages,
+              int const* nws,
+              float const* const* wins,
+              float const* inp,
+              float* res);
+
+conv_config
+conv_get_config(int n1, int n2, int nw);
+
+void
+conv_force_config(conv_config const* cfg);
+
+char const*
+conv_tuning_name();
+} // namespace isa_avx2
+
+namespace isa_avx512 {
+void
+conv(const int n1, const int n2, const int nw, float const* inp, float const* win, float* res);
+
+void
+conv_separable(const int n1,
+               const int n2,
+               const int nw,
+               float const* inp,
+               float const* col,
+               float const* row,
+               float* res);
+
+void
+conv_strided(const int n1,
+             const int n2,
+             const int nw,
+             const int s1,
+             const int s2,
+             const int d1,
+             const int d2,
+             float const* inp,
+             float const* win,
+             float* res);
+
+void
+conv_pipeline(const int n1,
+              const int n2,
+              const int n_stages,
+              int const* nws,
+              float const* const* wins,
+              float const* inp,
+              float* res);
+
+conv_config
+conv_get_config(int n1, int n2, int nw);
+
+void
+conv_force_config(conv_config const* cfg);
+
+char const*
+conv_tuning_name();
+} // namespace isa_avx512
+
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
+namespace {
+
+isa
+selected()
+{
+    static const isa selected_isa = select_isa();
+    return selected_isa;
+}
+
+} // namespace
+
+char const*
+conv_isa()
+{
+    return isa_name(selected());
+}
+
+void
+conv(const int n1, const int n2, const int nw, float const* inp, float const* win, float* res)
+{
+    switch (selected()) {
+        case isa::avx512:
+            return isa_avx512::conv(n1, n2, nw, inp, win, res);
+        case isa::avx2:
+            return isa_avx2::conv(n1, n2, nw, inp, win, res);
+        default:
+            return isa_sse::conv(n1, n2, nw, inp, win, res);
+    }
+}
+
+void
+conv_separable(const int n1,
+               const int n2,
+               const int nw,
+               float const* inp,
+               float const* col,
+               float const* row,
+               float* res)
+{
+    switch (selected()) {
+        case isa::avx512:
+            return isa_avx512::conv_separable(n1, n2, nw, inp, col, row, res);
+        case isa::avx2:
+            return isa_avx2::conv_separable(n1, n2, nw, inp, col, row, res);
+        default:
+            return isa_sse::conv_separable(n1, n2, nw, inp, col, row, res);
+    }
+}
+
+void
+conv_strided(const int n1,
+             const int n2,
+             const int nw,
+             const int s1,
+             const int s2,
+             const int d1,
+             const int d2,
+             float const* inp,
+             float const* win,
+             float* res)
+{
+    switch (selected()) {
+        case isa::avx512:
+            return isa_avx512::conv_strided(n1, n2, nw, s1, s2, d1, d2, inp, win, res);
+        case isa::avx2:
+            return isa_avx2::conv_strided(n1, n2, nw, s1, s2, d1, d2, inp, win, res);
+        default:
+            return isa_sse::conv_strided(n1, n2, nw, s1, s2, d1, d2, inp, win, res);
+    }
+}
+
+void
+conv_pipeline(const int n1,
+              const int n2,
+              const int n_stages,
+              int const* nws,
+              float const* const* wins,
+              float const* inp,
+              float* res)
+{
+    switch (selected()) {
+        case isa::avx512:
+            return isa_avx512::conv_pipeline(n1, n2, n_stages, nws, wins, inp, res);
+        case isa::avx2:
+            return isa_avx2::conv_pipeline(n1, n2, n_stages, nws, wins, inp, res);
+        default:
+            return isa_sse::conv_pipeline(n1, n2, n_stages, nws, wins, inp, res);
+    }
+}
+
+conv_config
+conv_get_config(int n1, int n2, int nw)
+{
+    switch (selected()) {
+        case isa::avx512:
+            return isa_avx512::conv_get_config(n1, n2, nw);
+        case isa::avx2:
+            return isa_avx2::conv_get_config(n1, n2, nw);
+        default:
+            return isa_sse::conv_get_config(n1, n2, nw);
+    }
+}
+
+/// forces the configuration of the chosen copy only, the one that the calls go to
+void
+conv_force_config(conv_config const* cfg)
+{
+    switch (selected()) {
+        case isa::avx512:
+            return isa_avx512::conv_force_config(cfg);
+        case isa::avx2:
+            return isa_avx2::conv_force_config(cfg);
+        default:
+            return isa_sse::conv_force_config(cfg);
+    }
+}
+
+char const*
+conv_tuning_name()
+{
+    switch (selected()) {
+        case isa::avx512:
+            return isa_avx512::conv_tuning_name();
+        case isa::avx2:
+            return isa_avx2::conv_tuning_name();
+        default:
+            return isa_sse::conv_tuning_name();
+    }
+}
+
+CMPE492_REGISTER_KERNEL(conv_fn, conv);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
+} // namespace cmpe492
@@ -0,0 +1,27 @@
+#include <cassert>
+
+#include "conv.hpp"
+#include "fft_conv.hpp"
+#include "registry.hpp"
+
+namespace cmpe492 {
+
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
+void
+conv(const int n1, const int n2, const int nw, float const* inp, float const* win, float* res)
+{
+    assert(nw % 2 == 1);
+
+    fft_conv(n1, n2, nw, inp, win, res);
+}
+
+CMPE492_REGISTER_KERNEL(conv_fn, conv);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
+} // namespace cmpe492
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include "conv_layer.hpp"
+#include "mm.hpp"
+#include "thread_pool.hpp"
+
+// the layer is lowered to matrix multiplication with im2col: output channel co of an image is
+// row co of filters (c_out by c_in * nw * nw) times the matrix whose column p holds the input
+// elements that the window of the output element p covers. the multiplication is done by sgemm()
+// from mm.hpp, which packs its operands into the layout of its micro-kernel.
+
+namespace cmpe492 {
+
+namespace {
+
+/// size of a block of the im2col matrix. the matrix has c_in * nw * nw times as many elements as
+/// the image, so it is built and multiplied a few rows of the output at a time.
+constexpr std::size_t col_block_bytes = 4 << 20;
+
+/// the im2col matrix of the output rows [r0, r1) of img (c_in x h x w).
+/// row (ci * nw + k1) * nw + k2 of col is channel ci of img shifted by (k1, k2) - nw / 2, its
+/// column (r - r0) * w + c is for the output element (r, c).
+void
+im2col(const int r0,
+       const int r1,
+       const int c_in,
+       const int h,
+       const int w,
+       const int nw,
+       float const* const img,
+       float* const col)
+{
+    const int hw = nw / 2;
+    const int cols = (r1 - r0) * w;
+
+    parallel_for(0, c_in * nw * nw, [&](int k) {
+        const int ci = k / (nw * nw);
+        const int k1 = k / nw % nw;
+        const int k2 = k % nw;
+
+        // the output columns [lo, hi) read input columns [lo + k2 - hw, hi + k2 - hw) of the image
+        const int lo = std::min(w, std::max(0, hw - k2));
+        const int hi = std::max(lo, std::min(w, w + hw - k2));
+
+        for (int r = r0; r < r1; r++) {
+            float* const out = col + static_cast<std::size_t>(k) * cols + (r - r0) * w;
+            const int ir = r + k1 - hw;
+
+            if (ir < 0 || ir >= h) {
+                std::fill(out, out + w, 0.0f);
+                continue;
+            }
+
+            float const* const in = img + (static_cast<std::size_t>(ci) * h + ir) * w;
+
+            std::fill(out, out + lo, 0.0f);
+            std::copy(in + lo + k2 - hw, in + hi + k2 - hw, out + lo);
+            std::fill(out + hi, out + w, 0.0f);
+        }
+    });
+}
+
+} // namespace
+
+void
+conv_layer(const int n,
+           const int c_in,
+           const int c_out,
+           const int h,
+           const int w,
+           const int nw,
+           float const* const inp,
+           float const* const filters,
+           float* const res)
+{
+    assert(nw % 2 == 1);
+
+    const int depth = c_in * nw * nw; // rows of the im2col matrix
+    const int hw_sz = h * w;
+
+    const std::size_t row_bytes = sizeof(float) * depth * std::max(1, w);
+    const int block_rows = static_cast<int>(std::clamp<std::size_t>(
+      col_block_bytes / row_bytes, 1, std::max(1, h)));
+
+    std::vector<float> col;
+
+    for (int b = 0; b < n; b++) {
+        float const* const img = inp + static_cast<std::size_t>(b) * c_in * hw_sz;
+        float* const out = res + static_cast<std::size_t>(b) * c_out * hw_sz;
+
+        // a 1 by 1 window needs no im2col, the image is the matrix
+        if (nw == 1) {
+            sgemm(transpose::no,
+                  transpose::no,
+                  c_out,
+                  c_in,
+                  hw_sz,
+                  1.0f,
+                  filters,
+                  c_in,
+                  img,
+                  hw_sz,
+                  0.0f,
+                  out,
+                  hw_sz);
+            continue;
+        }
+
+        col.resize(static_cast<std::size_t>(depth) * block_rows * w);
+
+        for (int r0 = 0; r0 < h; r0 += block_rows) {
+            const int r1 = std::min(h, r0 + block_rows);
+            const int cols = (r1 - r0) * w;
+
+            im2col(r0, r1, c_in, h, w, nw, img, col.data());
+
+            // the rows of the output channels are hw_sz apart
+            sgemm(transpose::no,
+                  transpose::no,
+                  c_out,
+                  depth,
+                  cols,
+                  1.0f,
+                  filters,
+                  depth,
+                  col.data(),
+                  cols,
+                  0.0f,
+                  out + r0 * w,
+                  hw_sz);
+        }
+    }
+}
+
+} // namespace cmpe492
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace cmpe492 {
+
+/// convolution layer of a neural network: convolve a batch of n images of c_in channels with
+/// c_out filters of c_in channels each, the sum over the input channels of conv() in conv.hpp.
+/// inp is n x c_in x h x w (nchw), filters is c_out x c_in x nw x nw, res is n x c_out x h x w,
+/// all stored contiguously. nw is odd and the input is 0 outside of the image, as in conv().
+void
+conv_layer(int n,
+           int c_in,
+           int c_out,
+           int h,
+           int w,
+           int nw,
+           float const* inp,
+           float const* filters,
+           float* res);
+
+} // namespace cmpe492
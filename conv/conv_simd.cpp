@@ -1,106 +1,178 @@
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <vector>
 
 #include "conv.hpp"
+#include "registry.hpp"
 #include "simd.hpp"
 
 namespace cmpe492 {
 
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
+namespace {
+
+using vector_t = float8_t;
+using vector_unalgn_t = float8_unalgn_t;
+
+constexpr int vw = sizeof(vector_t) / sizeof(float); // vector width
+
+/// the elements [j0, j1) of a row of the result. window row k1 is applied to the row
+/// src + k1 * ld, whose element j - off + c is the input element nw / 2 - c columns left of the
+/// result j.
 void
-conv(const int n1, const int n2, const int nw, float const* inp, float const* win, float* res)
+conv_row(const int j0,
+         const int j1,
+         const int nw,
+         const int wb,
+         float const* const __restrict src,
+         const int ld,
+         const int off,
+         vector_t const* const __restrict algn_win,
+         float* const __restrict out)
 {
-    using vector_t = float8_t;
-    using vector_unalgn_t = float8_unalgn_t;
+    for (int j = j0; j < j1; j++) {
+        float const* const s = src + (j - off);
 
-    constexpr int vw = sizeof(vector_t) / sizeof(float); // vector width
+        constexpr int rll = 3; // unroll
+        vector_t t[rll] = {};
 
-    assert(nw % 2 == 1);
+        for (int k1g = 0; k1g < nw / rll; k1g++) {
+            for (int k2 = 0; k2 < wb; k2++) {
+                for (int k1i = 0; k1i < rll; k1i++) {
+                    const int k1 = k1g * rll + k1i;
 
-    const int wb = (nw + vw - 1) / vw; // number of vectors in a row of the window
+                    vector_t inp_vec =
+                      *reinterpret_cast<vector_unalgn_t const*>(&s[k1 * ld + k2 * vw]);
 
-    vector_t* algn_win =
-      static_cast<vector_t*>(aligned_alloc(sizeof(vector_t), nw * wb * sizeof(vector_t)));
+                    vector_t win_vec = algn_win[k1 * wb + k2];
 
-    for (int i = 0; i < nw; i++) {
-        for (int j = 0; j < wb; j++) {
-            for (int k = 0; k < vw; k++) {
-                if (j * vw + k < nw) {
-                    algn_win[i * wb + j][k] = win[i * nw + j * vw + k];
-                } else {
-                    algn_win[i * wb + j][k] = 0.0f;
+                    t[k1i] += inp_vec * win_vec;
                 }
             }
         }
-    }
 
-    const int pd_n1 = n1 + nw - 1;
-    const int pd_n2 = n2 + wb * vw - 1;
-    float* padded_inp = new float[pd_n1 * pd_n2];
+        for (int k1 = nw / rll * rll; k1 < nw; k1++) {
+            for (int k2 = 0; k2 < wb; k2++) {
+                vector_t inp_vec = *reinterpret_cast<vector_unalgn_t const*>(&s[k1 * ld + k2 * vw]);
+
+                vector_t win_vec = algn_win[k1 * wb + k2];
 
-    for (int j = 0; j < nw / 2; j++) {
-        for (int i = 0; i < pd_n2; i++) {
-            padded_inp[j * pd_n2 + i] = 0;
-            padded_inp[(pd_n1 - 1 - j) * pd_n2 + i] = 0;
+                t[0] += inp_vec * win_vec;
+            }
         }
-    }
 
-    for (int i = 0; i < n1; i++) {
-        for (int j = 0; j < nw / 2; j++) {
-            padded_inp[(i + nw / 2) * pd_n2 + j] = 0;
+        for (int k = 1; k < rll; k++) {
+            t[0] += t[k];
         }
-        for (int j = nw / 2 + n2; j < pd_n2; j++) {
-            padded_inp[(i + nw / 2) * pd_n2 + j] = 0;
+        for (int k = 1; k < vw; k++) {
+            t[0][0] += t[0][k];
         }
 
-        for (int j = 0; j < n2; j++) {
-            padded_inp[(i + nw / 2) * pd_n2 + j + nw / 2] = inp[i * n2 + j];
+        out[j] = t[0][0];
+    }
+}
+
+/// copy the input rows [i - nw / 2, i + nw / 2] and columns [c0, c0 + w) to strip, whose rows
+/// are w apart. the elements out of inp are 0.
+void
+fill_strip(const int i,
+           const int c0,
+           const int w,
+           const int n1,
+           const int n2,
+           const int nw,
+           float const* const inp,
+           float* const strip)
+{
+    const int lo = std::max(0, c0);
+    const int hi = std::max(lo, std::min(n2, c0 + w));
+
+    for (int k1 = 0; k1 < nw; k1++) {
+        const int r = i - nw / 2 + k1;
+        float* const row = strip + k1 * w;
+
+        if (r < 0 || r >= n1) {
+            std::fill(row, row + w, 0.0f);
+            continue;
         }
+
+        std::fill(row, row + (lo - c0), 0.0f);
+        std::copy(inp + r * n2 + lo, inp + r * n2 + hi, row + (lo - c0));
+        std::fill(row + (hi - c0), row + w, 0.0f);
     }
+}
 
-    for (int i = 0; i < n1; i++) {
-        for (int j = 0; j < n2; j++) {
-            constexpr int rll = 3; // unroll
-            vector_t t[rll] = {};
+} // namespace
 
-            for (int k1g = 0; k1g < nw / rll; k1g++) {
-                for (int k2 = 0; k2 < wb; k2++) {
-                    for (int k1i = 0; k1i < rll; k1i++) {
-                        const int k1 = k1g * rll + k1i;
+void
+conv(const int n1, const int n2, const int nw, float const* inp, float const* win, float* res)
+{
+    assert(nw % 2 == 1);
 
-                        vector_t inp_vec = *reinterpret_cast<vector_unalgn_t*>(
-                          &padded_inp[(i + k1) * pd_n2 + j + k2 * vw]);
+    const int wb = (nw + vw - 1) / vw; // number of vectors in a row of the window
 
-                        vector_t win_vec = algn_win[k1 * wb + k2];
+    vector_t* algn_win =
+      static_cast<vector_t*>(aligned_alloc(sizeof(vector_t), nw * wb * sizeof(vector_t)));
 
-                        t[k1i] += inp_vec * win_vec;
-                    }
+    for (int i = 0; i < nw; i++) {
+        for (int j = 0; j < wb; j++) {
+            for (int k = 0; k < vw; k++) {
+                if (j * vw + k < nw) {
+                    algn_win[i * wb + j][k] = win[i * nw + j * vw + k];
+                } else {
+                    algn_win[i * wb + j][k] = 0.0f;
                 }
             }
+        }
+    }
 
-            for (int k1 = nw / rll * rll; k1 < nw; k1++) {
-                for (int k2 = 0; k2 < wb; k2++) {
-                    vector_t inp_vec = *reinterpret_cast<vector_unalgn_t*>(
-                      &padded_inp[(i + k1) * pd_n2 + j + k2 * vw]);
+    // the interior is read from inp directly. the rows and columns whose window crosses the
+    // border of inp are read from a padded copy of the part of the input they need, a strip of
+    // nw rows.
+    const int h = nw / 2;
+    const int span = wb * vw - 1; // columns read for a result, minus 1
 
-                    vector_t win_vec = algn_win[k1 * wb + k2];
+    // the results [jl, jr) of a row read columns [0, n2) of inp only
+    const int jl = std::min(h, n2);
+    const int jr = std::max(jl, n2 - span + h);
 
-                    t[0] += inp_vec * win_vec;
-                }
-            }
+    std::vector<float> strip;
 
-            for (int k = 1; k < rll; k++) {
-                t[0] += t[k];
-            }
-            for (int k = 1; k < vw; k++) {
-                t[0][0] += t[0][k];
-            }
+    // the results [j0, j1) of row i, from a strip
+    auto padded = [&](const int i, const int j0, const int j1) {
+        if (j0 >= j1) {
+            return;
+        }
+
+        const int w = j1 - j0 + span;
+        strip.resize(nw * w);
 
-            res[i * n2 + j] = t[0][0];
+        fill_strip(i, j0 - h, w, n1, n2, nw, inp, strip.data());
+        conv_row(j0, j1, nw, wb, strip.data(), w, j0, algn_win, res + i * n2);
+    };
+
+    for (int i = 0; i < n1; i++) {
+        if (i < h || i + h >= n1) {
+            padded(i, 0, n2);
+            continue;
         }
+
+        padded(i, 0, jl);
+        conv_row(jl, jr, nw, wb, inp + (i - h) * n2, n2, h, algn_win, res + i * n2);
+        padded(i, jr, n2);
     }
 
-    delete[] padded_inp;
     free(algn_win);
 }
 
-} // namespace cmpe492
\ No newline at end of file
+CMPE492_REGISTER_KERNEL(conv_fn, conv);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
+} // namespace cmpe492
@@ -1,145 +1,402 @@
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
 #include <iostream>
-#include <thread>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "conv.hpp"
+#include "conv_tuning.hpp"
+#include "registry.hpp"
 #include "simd.hpp"
+#include "thread_pool.hpp"
+#include "tuning.hpp"
+
+// the vector width can be chosen at compile time. conv_dispatch builds this file once per
+// instruction set, each copy in its own namespace named by CMPE492_NAMESPACE, and bench-conv
+// builds it into namespaces of its own too (see util/registry.hpp).
+#ifndef CMPE492_VECTOR_WIDTH
+#define CMPE492_VECTOR_WIDTH 8
+#endif
+
+// the kernels, those of the headers too, are compiled for the instruction set of the copy (see
+// util/simd.hpp), the headers they use are included above
+CMPE492_TARGET_BEGIN
+
+#include "direct_conv.hpp"
+#include "fft_conv.hpp"
+#include "pipeline_conv.hpp"
+#include "strided_conv.hpp"
 
 namespace cmpe492 {
 
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
 namespace {
 
-using vector_t = float8_t;
-using vector_unalgn_t = float8_unalgn_t;
+using vector_t = vector_of<CMPE492_VECTOR_WIDTH>::type;
+using vector_unalgn_t = vector_of<CMPE492_VECTOR_WIDTH>::unalgn_type;
 constexpr int vw = sizeof(vector_t) / sizeof(float); // vector width
 
+/// used for the shapes that are not tuned yet
+constexpr conv_config default_config = { 4, 0 };
+
+/// vectors of consecutive results in a row of the block of the direct kernel
+constexpr int direct_nv = 2;
+
+/// block of the strided kernel, rows of the result by vectors of consecutive results in a row,
+/// and the most rows of the result in a task of it
+constexpr int strided_rows = 2;
+constexpr int strided_nv = 4;
+constexpr int strided_task_rows = 16;
+
+/// rows of the result in a task of the separable convolution
+constexpr int sep_rows = 32;
+
+/// smallest window that is convolved with fft, which costs O(log) instead of O(nw * nw) per
+/// element. below it the direct kernel was faster on a 4000 x 4000 input.
+constexpr int fft_min_nw = (vw >= 8) ? 25 : 17;
+
 } // namespace
 
 namespace {
 
-/// partial convolution
-/// job for each worker thread
+/// the configuration set by conv_force_config(), if any. not synchronized, see conv_tuning.hpp.
+bool config_forced = false;
+conv_config forced_config = default_config;
+
+char const*
+tuning_name()
+{
+    static const std::string name = "conv_direct_w" + std::to_string(vw);
+    return name.c_str();
+}
+
+/// the configuration for the shape, see conv_get_config()
+conv_config
+config_for(int n1, int n2, int nw)
+{
+    if (config_forced) {
+        return forced_config;
+    }
+
+    const tuning_cache::shape_t shape = { size_class(n1), size_class(n2), nw };
+
+    // remembered per thread like in mm_simd2_mt.cpp, empty slots have block = 0
+    static thread_local std::array<std::pair<tuning_cache::shape_t, conv_config>, 16> seen = {};
+    static thread_local unsigned seen_version = 0;
+
+    auto& cache = tuning_cache::instance();
+    const unsigned version = cache.version();
+    if (version != seen_version) {
+        seen = {};
+        seen_version = version;
+    }
+
+    auto& slot = seen[(shape[0] * 64 * 64 + shape[1] * 64 + shape[2]) % seen.size()];
+    if (slot.second.block != 0 && slot.first == shape) {
+        return slot.second;
+    }
+
+    const auto params = cache.lookup(tuning_name(), shape);
+
+    conv_config cfg = default_config;
+    if (params.size() == 2 && params[0] >= 1 && params[0] <= 4) {
+        cfg = { params[0], params[1] };
+    }
+
+    slot = { shape, cfg };
+    return cfg;
+}
+
+/// horizontal pass of the separable convolution, out[i - i0] = inp[i] convolved with row
+/// for each i in [i0, i1). the rows of out are n2 apart, pd_row has room for n2 + nw - 1 floats.
 void
-conv_helper(const int n1_fr,
-            const int n1_to,
-            const int n2,
-            const int pd_n2,
-            const int nw,
-            const int wb,
-            float const* const padded_inp,
-            vector_t const* const algn_win,
-            float* const res)
+row_pass(const int i0,
+         const int i1,
+         const int n2,
+         const int nw,
+         float const* const inp,
+         float const* const row,
+         float* const pd_row,
+         float* const out)
 {
-    for (int i = n1_fr; i < n1_to; i++) {
-        for (int j = 0; j < n2; j++) {
-            constexpr int rll = 3; // unroll
-            vector_t t[rll] = {};
+    const int h = nw / 2;
 
-            for (int k1g = 0; k1g < nw / rll; k1g++) {
-                for (int k2 = 0; k2 < wb; k2++) {
-                    for (int k1i = 0; k1i < rll; k1i++) {
-                        const int k1 = k1g * rll + k1i;
+    std::fill(pd_row, pd_row + h, 0.0f);
+    std::fill(pd_row + h + n2, pd_row + n2 + nw - 1, 0.0f);
 
-                        vector_t inp_vec = *reinterpret_cast<vector_unalgn_t const*>(
-                          &padded_inp[(i + k1) * pd_n2 + j + k2 * vw]);
+    for (int i = i0; i < i1; i++) {
+        std::copy(inp + i * n2, inp + (i + 1) * n2, pd_row + h);
 
-                        vector_t win_vec = algn_win[k1 * wb + k2];
+        float* const o = out + (i - i0) * n2;
 
-                        t[k1i] += inp_vec * win_vec;
-                    }
-                }
-            }
+        int j = 0;
+        for (; j + vw <= n2; j += vw) {
+            vector_t t = {};
 
-            for (int k1 = nw / rll * rll; k1 < nw; k1++) {
-                for (int k2 = 0; k2 < wb; k2++) {
-                    vector_t inp_vec = *reinterpret_cast<vector_unalgn_t const*>(
-                      &padded_inp[(i + k1) * pd_n2 + j + k2 * vw]);
+            for (int k = 0; k < nw; k++) {
+                t += row[k] * *reinterpret_cast<vector_unalgn_t const*>(&pd_row[j + k]);
+            }
 
-                    vector_t win_vec = algn_win[k1 * wb + k2];
+            *reinterpret_cast<vector_unalgn_t*>(&o[j]) = t;
+        }
+        for (; j < n2; j++) {
+            float t = 0.0f;
 
-                    t[0] += inp_vec * win_vec;
-                }
+            for (int k = 0; k < nw; k++) {
+                t += row[k] * pd_row[j + k];
             }
 
-            for (int k = 1; k < rll; k++) {
-                t[0] += t[k];
+            o[j] = t;
+        }
+    }
+}
+
+/// vertical pass of the separable convolution for the rows [i0, i1) of res.
+/// tmp holds the result of the horizontal pass for the rows [t0, t1), rows out of it are 0.
+void
+col_pass(const int i0,
+         const int i1,
+         const int t0,
+         const int t1,
+         const int n2,
+         const int nw,
+         float const* const tmp,
+         float const* const col,
+         float* const res)
+{
+    const int h = nw / 2;
+
+    for (int i = i0; i < i1; i++) {
+        const int k_fr = std::max(0, t0 - (i - h));
+        const int k_to = std::min(nw, t1 - (i - h));
+
+        float* const r = res + i * n2;
+        const int tr = i - h - t0; // row of tmp for k = 0
+
+        int j = 0;
+        for (; j + vw <= n2; j += vw) {
+            vector_t t = {};
+
+            for (int k = k_fr; k < k_to; k++) {
+                t += col[k] * *reinterpret_cast<vector_unalgn_t const*>(&tmp[(tr + k) * n2 + j]);
             }
-            for (int k = 1; k < vw; k++) {
-                t[0][0] += t[0][k];
+
+            *reinterpret_cast<vector_unalgn_t*>(&r[j]) = t;
+        }
+        for (; j < n2; j++) {
+            float t = 0.0f;
+
+            for (int k = k_fr; k < k_to; k++) {
+                t += col[k] * tmp[(tr + k) * n2 + j];
             }
 
-            res[i * n2 + j] = t[0][0];
+            r[j] = t;
         }
     }
 }
 
-} // namespace
-
+/// convolution with the window col * row^T, see conv_separable().
+/// each task takes sep_rows rows of the result and runs the horizontal pass on the rows of inp
+/// they need, so that the intermediate rows are still in cache for the vertical pass.
 void
-conv(const int n1, const int n2, const int nw, float const* inp, float const* win, float* res)
+separable(const int n1,
+          const int n2,
+          const int nw,
+          float const* inp,
+          float const* col,
+          float const* row,
+          float* res)
 {
-    assert(nw % 2 == 1);
+    const int h = nw / 2;
+
+    parallel_for(0, (n1 + sep_rows - 1) / sep_rows, [&](int task) {
+        const int i0 = task * sep_rows;
+        const int i1 = std::min(i0 + sep_rows, n1);
+        const int t0 = std::max(0, i0 - h);
+        const int t1 = std::min(n1, i1 + h);
+
+        static thread_local std::vector<float> buf;
+        buf.resize((t1 - t0) * n2 + n2 + nw - 1);
+
+        float* const tmp = buf.data();
+        float* const pd_row = buf.data() + (t1 - t0) * n2;
+
+        row_pass(t0, t1, n2, nw, inp, row, pd_row, tmp);
+        col_pass(i0, i1, t0, t1, n2, nw, tmp, col, res);
+    });
+}
 
-    const int wb = (nw + vw - 1) / vw; // number of vectors in a row of the window
+/// if win (nw by nw) is the outer product of two vectors, within the rounding errors of float,
+/// put them into col and row and return true
+bool
+rank1_factors(const int nw, float const* win, float* col, float* row)
+{
+    // the largest element is a safe pivot
+    int p = 0;
+    for (int i = 1; i < nw * nw; i++) {
+        if (std::abs(win[i]) > std::abs(win[p])) {
+            p = i;
+        }
+    }
 
-    vector_t* algn_win =
-      static_cast<vector_t*>(aligned_alloc(sizeof(vector_t), nw * wb * sizeof(vector_t)));
+    const float pivot = win[p];
+    if (pivot == 0.0f) {
+        return false;
+    }
+
+    const int pi = p / nw;
+    const int pj = p % nw;
+
+    for (int k = 0; k < nw; k++) {
+        col[k] = win[k * nw + pj];
+        row[k] = win[pi * nw + k] / pivot;
+    }
+
+    const float tolerance = 1e-6f * std::abs(pivot);
 
     for (int i = 0; i < nw; i++) {
-        for (int j = 0; j < wb; j++) {
-            for (int k = 0; k < vw; k++) {
-                if (j * vw + k < nw) {
-                    algn_win[i * wb + j][k] = win[i * nw + j * vw + k];
-                } else {
-                    algn_win[i * wb + j][k] = 0.0f;
-                }
+        for (int j = 0; j < nw; j++) {
+            if (std::abs(win[i * nw + j] - col[i] * row[j]) > tolerance) {
+                return false;
             }
         }
     }
 
-    const int pd_n1 = n1 + nw - 1;
-    const int pd_n2 = n2 + wb * vw - 1;
-    float* padded_inp = new float[pd_n1 * pd_n2];
+    return true;
+}
+
+} // namespace
+
+void
+conv_separable(const int n1,
+               const int n2,
+               const int nw,
+               float const* inp,
+               float const* col,
+               float const* row,
+               float* res)
+{
+    assert(nw % 2 == 1);
 
-    for (int j = 0; j < nw / 2; j++) {
-        for (int i = 0; i < pd_n2; i++) {
-            padded_inp[j * pd_n2 + i] = 0;
-            padded_inp[(pd_n1 - 1 - j) * pd_n2 + i] = 0;
+    separable(n1, n2, nw, inp, col, row, res);
+}
+
+void
+conv(const int n1, const int n2, const int nw, float const* inp, float const* win, float* res)
+{
+    assert(nw % 2 == 1);
+
+    // a separable window takes 2 * nw operations per element instead of nw * nw
+    if (nw >= 3) {
+        std::vector<float> col(nw), row(nw);
+
+        if (rank1_factors(nw, win, col.data(), row.data())) {
+            separable(n1, n2, nw, inp, col.data(), row.data(), res);
+            return;
         }
     }
 
-    for (int i = 0; i < n1; i++) {
-        for (int j = 0; j < nw / 2; j++) {
-            padded_inp[(i + nw / 2) * pd_n2 + j] = 0;
-        }
-        for (int j = nw / 2 + n2; j < pd_n2; j++) {
-            padded_inp[(i + nw / 2) * pd_n2 + j] = 0;
-        }
+    if (nw >= fft_min_nw) {
+        fft_conv(n1, n2, nw, inp, win, res);
+        return;
+    }
 
-        for (int j = 0; j < n2; j++) {
-            padded_inp[(i + nw / 2) * pd_n2 + j + nw / 2] = inp[i * n2 + j];
-        }
+    const conv_config cfg = config_for(n1, n2, nw);
+
+    auto direct = direct_conv<vector_t, 4, direct_nv>;
+    switch (cfg.block) {
+        case 1:
+            direct = direct_conv<vector_t, 1, direct_nv>;
+            break;
+        case 2:
+            direct = direct_conv<vector_t, 2, direct_nv>;
+            break;
+        case 3:
+            direct = direct_conv<vector_t, 3, direct_nv>;
+            break;
     }
 
-    const int num_thr = 4;
-    std::vector<std::thread> threads(num_thr);
+    const int num_thr = get_num_threads();
+    const int rows = std::max(1, (cfg.rows > 0) ? cfg.rows : (n1 + num_thr - 1) / num_thr);
 
-    for (int i = 0; i < num_thr; i++) {
-        int beg = i * ((n1 + num_thr - 1) / num_thr);
-        int end = (i + 1) * ((n1 + num_thr - 1) / num_thr);
-        end = std::min(end, n1);
+    direct(n1, n2, nw, inp, win, res, rows);
+}
+
+void
+conv_strided(const int n1,
+             const int n2,
+             const int nw,
+             const int s1,
+             const int s2,
+             const int d1,
+             const int d2,
+             float const* inp,
+             float const* win,
+             float* res)
+{
+    assert(nw % 2 == 1 && s1 >= 1 && s2 >= 1 && d1 >= 1 && d2 >= 1);
 
-        threads[i] =
-          std::thread(conv_helper, beg, end, n2, pd_n2, nw, wb, padded_inp, algn_win, res);
+    if (s1 == 1 && s2 == 1 && d1 == 1 && d2 == 1) {
+        conv(n1, n2, nw, inp, win, res);
+        return;
     }
 
-    for (int i = 0; i < num_thr; i++) {
-        threads[i].join();
+    const int m1 = (n1 + s1 - 1) / s1;
+    const int num_thr = get_num_threads();
+    const int rows = std::clamp((m1 + num_thr - 1) / num_thr, 1, strided_task_rows);
+
+    strided_conv<vector_t, strided_rows, strided_nv>(
+      n1, n2, nw, s1, s2, d1, d2, inp, win, res, rows);
+}
+
+void
+conv_pipeline(const int n1,
+              const int n2,
+              const int n_stages,
+              int const* nws,
+              float const* const* wins,
+              float const* inp,
+              float* res)
+{
+    assert(std::all_of(nws, nws + n_stages, [](int nw) { return nw % 2 == 1; }));
+
+    pipeline_conv<vector_t, default_config.block, direct_nv>(n1, n2, n_stages, nws, wins, inp, res);
+}
+
+conv_config
+conv_get_config(int n1, int n2, int nw)
+{
+    return config_for(n1, n2, nw);
+}
+
+void
+conv_force_config(conv_config const* cfg)
+{
+    config_forced = (cfg != nullptr);
+    if (cfg) {
+        forced_config = *cfg;
     }
+}
 
-    delete[] padded_inp;
-    free(algn_win);
+char const*
+conv_tuning_name()
+{
+    return tuning_name();
 }
 
-} // namespace cmpe492
\ No newline at end of file
+CMPE492_TARGET_END
+
+CMPE492_REGISTER_KERNEL(conv_fn, conv);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
+} // namespace cmpe492
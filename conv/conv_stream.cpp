@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cassert>
+
+#include "conv_stream.hpp"
+#include "direct_conv.hpp"
+#include "simd.hpp"
+
+namespace cmpe492 {
+
+namespace {
+
+using vector_t = float8_t;
+constexpr int vw = sizeof(vector_t) / sizeof(float); // vector width
+
+/// rows of the result computed at once by the direct kernel, and its vectors per row
+constexpr int block = 4;
+constexpr int block_nv = 2;
+
+} // namespace
+
+// row q of the image is stored at slots q % slots_ and q % slots_ + slots_ of the ring, where
+// slots_ = nw + block - 1 is what a block of result rows reads. the rows a block reads are then
+// consecutive in the ring, starting at the slot of the first one, as direct_block() needs them.
+// rows -nw / 2 to -1 and the nw / 2 rows after the end of the image are zeros.
+
+conv_stream::conv_stream(const int n2, const int nw, float const* const win)
+  : n2_(n2)
+  , nw_(nw)
+  , len_((n2 + vw - 1) / vw * vw)
+  , ld_(len_ + nw - 1)
+  , slots_(nw + block - 1)
+  , win_(win, win + nw * nw)
+  , ring_(2 * slots_ * ld_, 0.0f)
+  , out_(block * len_)
+{
+    assert(nw % 2 == 1);
+
+    reset();
+}
+
+void
+conv_stream::reset()
+{
+    next_ = 0;
+    done_ = 0;
+    finished_ = false;
+
+    // the zero rows above the image
+    for (int k = 0; k < nw_ / 2; k++) {
+        store(nullptr);
+    }
+}
+
+void
+conv_stream::store(float const* const row)
+{
+    const int slot = static_cast<int>(next_ % slots_);
+
+    for (float* dst : { &ring_[slot * ld_], &ring_[(slot + slots_) * ld_] }) {
+        // the zeros around the row are never overwritten
+        if (row) {
+            std::copy(row, row + n2_, dst + nw_ / 2);
+        } else {
+            std::fill(dst + nw_ / 2, dst + nw_ / 2 + n2_, 0.0f);
+        }
+    }
+
+    next_++;
+}
+
+/// write up to max_rows of the complete result rows to res, in blocks of block rows while there
+/// are enough of them
+int
+conv_stream::emit(const int max_rows, float* const res)
+{
+    const int h = nw_ / 2;
+    int written = 0;
+
+    auto ready = [&] { return static_cast<int>(next_ - 2 * h - done_); };
+
+    while (written < max_rows && ready() > 0) {
+        // the first row read for result row done_ is the image row done_ - h, stored at index
+        // done_ of the ring
+        const int slot = static_cast<int>(done_ % slots_);
+        float const* const src = &ring_[slot * ld_];
+
+        const int rows = (ready() >= block && max_rows - written >= block) ? block : 1;
+
+        if (rows == block) {
+            direct_block<vector_t, block, block_nv>(
+              0, len_, nw_, src, ld_, 0, win_.data(), out_.data(), len_);
+        } else {
+            direct_block<vector_t, 1, block_nv>(
+              0, len_, nw_, src, ld_, 0, win_.data(), out_.data(), len_);
+        }
+
+        for (int r = 0; r < rows; r++) {
+            std::copy(&out_[r * len_], &out_[r * len_] + n2_, res + (written + r) * n2_);
+        }
+
+        written += rows;
+        done_ += rows;
+    }
+
+    return written;
+}
+
+int
+conv_stream::push(const int rows, float const* const inp, float* const res)
+{
+    assert(!finished_);
+
+    int written = 0;
+
+    for (int i = 0; i < rows; i++) {
+        store(inp + i * n2_);
+
+        // a full block is written as soon as it is complete, before the ring overwrites the
+        // rows it needs
+        if (next_ - 2 * (nw_ / 2) - done_ >= block) {
+            written += emit(block, res + written * n2_);
+        }
+    }
+
+    return written + emit(rows - written, res + written * n2_);
+}
+
+int
+conv_stream::finish(float* const res)
+{
+    assert(!finished_);
+
+    int written = 0;
+
+    // the zero rows below the image
+    for (int k = 0; k < nw_ / 2; k++) {
+        store(nullptr);
+        written += emit(1, res + written * n2_);
+    }
+
+    finished_ = true;
+
+    return written;
+}
+
+} // namespace cmpe492
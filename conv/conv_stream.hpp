@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+namespace cmpe492 {
+
+/// convolution of an image that arrives a few rows at a time, like conv() in conv.hpp.
+///
+/// push() takes the next rows of the input and writes the rows of the result whose window is
+/// complete, and finish() writes the last nw / 2 rows once the input has ended. only the last
+/// rows that a result row still needs are kept, so the memory is O(nw * n2) whatever the height
+/// of the image. the rows are convolved on the calling thread.
+class conv_stream
+{
+    int n2_, nw_;
+    int len_;   // n2 rounded up to whole vectors
+    int ld_;    // length of a row of the ring, with nw / 2 zeros before the input
+    int slots_; // rows of the ring
+    long next_; // index of the next row stored in the ring, the first rows are zeros
+    long done_; // rows of the result written so far
+    bool finished_;
+
+    std::vector<float> win_;
+    std::vector<float> ring_; // each row is stored twice, at slot and slot + slots_
+    std::vector<float> out_;
+
+    void store(float const* row);
+    int emit(int max_rows, float* res);
+
+public:
+    /// convolve rows of n2 elements with win, nw by nw, nw is odd
+    conv_stream(int n2, int nw, float const* win);
+
+    /// append rows rows of the input (rows by n2) to the image and write the result rows that
+    /// became complete to res, which needs room for rows rows. returns the number of rows
+    /// written. once the first nw / 2 rows are in, each row pushed completes a row of the result.
+    int push(int rows, float const* inp, float* res);
+
+    /// end the image and write the remaining rows of the result to res, which needs room for
+    /// nw / 2 rows. returns the number of rows written.
+    int finish(float* res);
+
+    /// start a new image with the same width and window
+    void reset();
+
+    /// rows of the result written so far
+    long rows_done() const { return done_; }
+};
+
+} // namespace cmpe492
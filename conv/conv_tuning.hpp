@@ -0,0 +1,30 @@
+#pragma once
+
+namespace cmpe492 {
+
+/// runtime parameters of the multi-threaded conv kernel (conv_simd_mt).
+/// block is the number of rows of the result that the direct kernel keeps in registers (1 to 4),
+/// and the rows of the result are handed out to the threads in tasks of rows rows, or split evenly
+/// among them if rows is 0.
+struct conv_config
+{
+    int block;
+    int rows;
+};
+
+/// the configuration that conv() uses for the shape: the one found by the autotuner for its shape
+/// class on this cpu (see tuning.hpp), or the default one
+conv_config
+conv_get_config(int n1, int n2, int nw);
+
+/// use cfg for all the following calls instead of looking it up, or stop doing so if cfg is null.
+/// used by the autotuner to measure the candidates. not synchronized with the calls, it must not
+/// be called while other threads are running the kernel.
+void
+conv_force_config(conv_config const* cfg);
+
+/// name of the kernel in the tuning cache, includes the vector width
+char const*
+conv_tuning_name();
+
+} // namespace cmpe492
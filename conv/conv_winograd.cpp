@@ -0,0 +1,34 @@
+#include <cassert>
+
+#include "conv.hpp"
+#include "fft_conv.hpp"
+#include "registry.hpp"
+#include "simd.hpp"
+#include "winograd_conv.hpp"
+
+namespace cmpe492 {
+
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
+void
+conv(const int n1, const int n2, const int nw, float const* inp, float const* win, float* res)
+{
+    assert(nw % 2 == 1);
+
+    // winograd only has algorithms for 3 by 3 and 5 by 5 windows
+    if (has_winograd(nw)) {
+        winograd_conv<float8_t>(n1, n2, nw, inp, win, res);
+    } else {
+        fft_conv(n1, n2, nw, inp, win, res);
+    }
+}
+
+CMPE492_REGISTER_KERNEL(conv_fn, conv);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
+} // namespace cmpe492
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+// direct convolution vectorized across the columns of the result.
+
+namespace cmpe492 {
+
+namespace {
+
+/// one step of the block kernel: the input row ir of the block, shifted by k2 columns, is loaded
+/// once and multiplied with the window element k1 = ir - r of every row r of the block it
+/// contributes to, broadcast from win. with check set, the rows r with k1 out of the window
+/// are skipped, which only happens in the first and last rows - 1 input rows.
+template<typename vector_t, int rows, int nv, bool check>
+inline void
+direct_step(vector_t (&acc)[rows][nv],
+            const int ir,
+            const int k2,
+            const int nw,
+            float const* __restrict s,
+            const int ld,
+            float const* __restrict win)
+{
+    using vector_unalgn_t = typename vector_of<sizeof(vector_t) / sizeof(float)>::unalgn_type;
+    constexpr int vw = sizeof(vector_t) / sizeof(float);
+
+    vector_t in[nv];
+
+#pragma GCC unroll 4
+    for (int v = 0; v < nv; v++) {
+        in[v] = *reinterpret_cast<vector_unalgn_t const*>(&s[ir * ld + k2 + v * vw]);
+    }
+
+#pragma GCC unroll 8
+    for (int r = 0; r < rows; r++) {
+        const int k1 = ir - r;
+
+        if (check && (k1 < 0 || k1 >= nw)) {
+            continue;
+        }
+
+        const float w = win[k1 * nw + k2];
+
+#pragma GCC unroll 4
+        for (int v = 0; v < nv; v++) {
+            acc[r][v] += w * in[v];
+        }
+    }
+}
+
+/// rows consecutive rows of the result, the columns [j0, j1), a whole number of vectors.
+/// window row k1 of result row r is applied to the row src + (r + k1) * ld, whose element
+/// j - off + c is the input element nw / 2 - c columns left of the result j. the result rows are
+/// ldo apart.
+///
+/// nv vectors of consecutive results of each row are kept in registers. every input vector is
+/// loaded once per block and used for all the rows of the block, so there are no horizontal sums
+/// and an input load is shared by up to rows * vw results.
+template<typename vector_t, int rows, int nv>
+void
+direct_block(const int j0,
+             const int j1,
+             const int nw,
+             float const* const __restrict src,
+             const int ld,
+             const int off,
+             float const* const __restrict win,
+             float* const __restrict out,
+             const int ldo)
+{
+    constexpr int vw = sizeof(vector_t) / sizeof(float);
+    using vector_unalgn_t = typename vector_of<vw>::unalgn_type;
+
+    // computes the results [j, j + n * vw) of the block
+    auto vectors = [&](auto n_tag, const int j) {
+        constexpr int n = decltype(n_tag)::value;
+
+        float const* const s = src + (j - off);
+        vector_t acc[rows][n] = {};
+
+        const int ir_main = std::min(rows - 1, nw); // first input row used by all result rows
+        const int ir_tail = std::max(ir_main, nw);  // first input row not used by row 0
+
+        for (int ir = 0; ir < ir_main; ir++) {
+            for (int k2 = 0; k2 < nw; k2++) {
+                direct_step<vector_t, rows, n, true>(acc, ir, k2, nw, s, ld, win);
+            }
+        }
+        for (int ir = ir_main; ir < ir_tail; ir++) {
+            for (int k2 = 0; k2 < nw; k2++) {
+                direct_step<vector_t, rows, n, false>(acc, ir, k2, nw, s, ld, win);
+            }
+        }
+        for (int ir = ir_tail; ir < nw + rows - 1; ir++) {
+            for (int k2 = 0; k2 < nw; k2++) {
+                direct_step<vector_t, rows, n, true>(acc, ir, k2, nw, s, ld, win);
+            }
+        }
+
+        for (int r = 0; r < rows; r++) {
+            for (int v = 0; v < n; v++) {
+                *reinterpret_cast<vector_unalgn_t*>(&out[r * ldo + j + v * vw]) = acc[r][v];
+            }
+        }
+    };
+
+    int j = j0;
+    for (; j + nv * vw <= j1; j += nv * vw) {
+        vectors(std::integral_constant<int, nv>{}, j);
+    }
+    for (; j + vw <= j1; j += vw) {
+        vectors(std::integral_constant<int, 1>{}, j);
+    }
+}
+
+/// copy the input rows [i0, i0 + n_rows) and columns [c0, c0 + w) to strip, whose rows are w
+/// apart. the elements out of inp are 0.
+inline void
+fill_strip(const int i0,
+           const int n_rows,
+           const int c0,
+           const int w,
+           const int n1,
+           const int n2,
+           float const* const inp,
+           float* const strip)
+{
+    const int lo = std::max(0, c0);
+    const int hi = std::max(lo, std::min(n2, c0 + w));
+
+    for (int k = 0; k < n_rows; k++) {
+        const int r = i0 + k;
+        float* const row = strip + k * w;
+
+        if (r < 0 || r >= n1) {
+            std::fill(row, row + w, 0.0f);
+            continue;
+        }
+
+        std::fill(row, row + (lo - c0), 0.0f);
+        std::copy(inp + r * n2 + lo, inp + r * n2 + hi, row + (lo - c0));
+        std::fill(row + (hi - c0), row + w, 0.0f);
+    }
+}
+
+/// the rows [i0, i0 + rows) and columns [c0, c1) of the result.
+/// the interior is read from inp directly. the results whose window crosses the border of inp
+/// are read from a padded copy of the part of the input they need, a strip of rows + nw - 1 rows.
+template<typename vector_t, int rows, int nv>
+void
+direct_rows(const int i0,
+            const int c0,
+            const int c1,
+            const int n1,
+            const int n2,
+            const int nw,
+            float const* const inp,
+            float const* const win,
+            float* const res)
+{
+    constexpr int vw = sizeof(vector_t) / sizeof(float);
+
+    const int h = nw / 2;
+
+    static thread_local std::vector<float> strip;
+
+    // the results [j0, j1) of the rows, from a strip. they are computed in whole vectors into a
+    // buffer after the strip, with the results past j1 dropped, instead of with the scalar code
+    // of direct_block(), which would take most of the time for narrow inputs.
+    auto padded = [&](const int j0, const int j1) {
+        if (j0 >= j1) {
+            return;
+        }
+
+        const int len = (j1 - j0 + vw - 1) / vw * vw;
+        const int w = len + nw - 1;
+        strip.resize((rows + nw - 1) * w + rows * len);
+
+        float* const out = strip.data() + (rows + nw - 1) * w;
+
+        fill_strip(i0 - h, rows + nw - 1, j0 - h, w, n1, n2, inp, strip.data());
+        direct_block<vector_t, rows, nv>(0, len, nw, strip.data(), w, 0, win, out, len);
+
+        for (int r = 0; r < rows; r++) {
+            std::copy(out + r * len, out + r * len + (j1 - j0), res + (i0 + r) * n2 + j0);
+        }
+    };
+
+    if (i0 < h || i0 + rows - 1 + h >= n1) {
+        padded(c0, c1);
+        return;
+    }
+
+    // the results [jl, jr) of a row read columns [0, n2) of inp only, and are whole vectors
+    const int jl = std::clamp(h, c0, c1);
+    const int jr = jl + (std::clamp(n2 - h, jl, c1) - jl) / vw * vw;
+
+    padded(c0, jl);
+    direct_block<vector_t, rows, nv>(
+      jl, jr, nw, inp + (i0 - h) * n2, n2, h, win, res + i0 * n2, n2);
+    padded(jr, c1);
+}
+
+/// the rows [i0, i1) and columns [c0, c1) of the result, in blocks of rows rows, see
+/// direct_block()
+template<typename vector_t, int rows, int nv>
+void
+direct_tile(const int i0,
+            const int i1,
+            const int c0,
+            const int c1,
+            const int n1,
+            const int n2,
+            const int nw,
+            float const* const inp,
+            float const* const win,
+            float* const res)
+{
+    int i = i0;
+    for (; i + rows <= i1; i += rows) {
+        direct_rows<vector_t, rows, nv>(i, c0, c1, n1, n2, nw, inp, win, res);
+    }
+    for (; i < i1; i++) {
+        direct_rows<vector_t, 1, nv>(i, c0, c1, n1, n2, nw, inp, win, res);
+    }
+}
+
+/// input read by a block of rows of a tile of the direct kernel, in bytes. consecutive blocks
+/// share nw - 1 of their rows, which stay in the l2 cache if the tile is narrow enough.
+constexpr int direct_tile_bytes = 256 * 1024;
+
+/// convolve inp (n1 by n2) with win (nw by nw) like conv() in conv.hpp, with the direct kernel.
+///
+/// the result is split into tiles of task_rows rows, and as many columns as keep the input of a
+/// block of rows within direct_tile_bytes. the tiles are scheduled on the thread pool along the
+/// rows of tiles, so that the threads work on neighboring tiles of the same rows of the input.
+/// the column boundaries of the tiles are nw / 2 plus a multiple of the vectors of a block, so
+/// that only the last tile of a row has columns left over from the vectors.
+template<typename vector_t, int rows, int nv>
+void
+direct_conv(const int n1,
+            const int n2,
+            const int nw,
+            float const* const inp,
+            float const* const win,
+            float* const res,
+            const int task_rows)
+{
+    constexpr int step = nv * sizeof(vector_t) / sizeof(float); // columns of a block
+
+    const int h = nw / 2;
+    const int tw =
+      std::max(1, direct_tile_bytes / int(sizeof(float)) / (rows + nw - 1) / step) * step;
+
+    // tile c covers the columns [bound(c), bound(c + 1))
+    auto bound = [&](const int c) { return c == 0 ? 0 : std::min(n2, h + c * tw); };
+
+    const int tiles1 = (n1 + task_rows - 1) / task_rows;
+    const int tiles2 = std::max(1, (n2 - h + tw - 1) / tw);
+
+    parallel_for(0, tiles1 * tiles2, [&](int t) {
+        const int i0 = t / tiles2 * task_rows;
+        const int i1 = std::min(i0 + task_rows, n1);
+        const int c = t % tiles2;
+
+        direct_tile<vector_t, rows, nv>(
+          i0, i1, bound(c), bound(c + 1), n1, n2, nw, inp, win, res);
+    });
+}
+
+} // namespace
+
+} // namespace cmpe492
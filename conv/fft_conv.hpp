@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+// convolution through the fast fourier transform, for large windows.
+
+namespace cmpe492 {
+
+namespace {
+
+/// radix-2 fft of a fixed size n, a power of 2, on split complex data (real and imaginary parts in
+/// separate arrays).
+/// an element can be a row of m consecutive numbers, then m independent transforms are done at
+/// once, which is how the columns of a 2d array are transformed without transposing it.
+class fft_plan
+{
+    int n_ = 0;
+    std::vector<int> rev_;         // bit-reversal permutation
+    std::vector<float> cos_, sin_; // twiddle factors exp(-2 pi i k / n), k < n / 2
+
+public:
+    fft_plan() = default;
+
+    explicit fft_plan(int n)
+      : n_(n)
+      , rev_(n)
+      , cos_(n / 2)
+      , sin_(n / 2)
+    {
+        int bits = 0;
+        while ((1 << bits) < n) {
+            bits++;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int r = 0;
+            for (int b = 0; b < bits; b++) {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            rev_[i] = r;
+        }
+
+        const double pi = std::acos(-1.0);
+        for (int k = 0; k < n / 2; k++) {
+            cos_[k] = static_cast<float>(std::cos(2 * pi * k / n));
+            sin_[k] = static_cast<float>(-std::sin(2 * pi * k / n));
+        }
+    }
+
+    int size() const { return n_; }
+
+    /// in-place transform of n elements of m numbers each, element e is re[e * m, (e + 1) * m).
+    /// the inverse transform is not scaled.
+    void transform(float* re, float* im, const int m, const bool inverse) const
+    {
+        for (int i = 0; i < n_; i++) {
+            const int r = rev_[i];
+            if (i < r) {
+                std::swap_ranges(re + i * m, re + (i + 1) * m, re + r * m);
+                std::swap_ranges(im + i * m, im + (i + 1) * m, im + r * m);
+            }
+        }
+
+        const float sign = inverse ? -1.0f : 1.0f;
+
+        for (int len = 2; len <= n_; len *= 2) {
+            const int half = len / 2;
+            const int step = n_ / len;
+
+            for (int blk = 0; blk < n_; blk += len) {
+                for (int j = 0; j < half; j++) {
+                    const float wr = cos_[j * step];
+                    const float wi = sign * sin_[j * step];
+
+                    float* __restrict ar = re + (blk + j) * m;
+                    float* __restrict ai = im + (blk + j) * m;
+                    float* __restrict br = re + (blk + j + half) * m;
+                    float* __restrict bi = im + (blk + j + half) * m;
+
+                    for (int c = 0; c < m; c++) {
+                        const float tr = br[c] * wr - bi[c] * wi;
+                        const float ti = br[c] * wi + bi[c] * wr;
+
+                        br[c] = ar[c] - tr;
+                        bi[c] = ai[c] - ti;
+                        ar[c] += tr;
+                        ai[c] += ti;
+                    }
+                }
+            }
+        }
+    }
+};
+
+/// 2d real-to-complex and complex-to-real transforms of n1 by n2 arrays, both powers of 2.
+/// the spectrum keeps the m = n2 / 2 + 1 columns that are not redundant, as n1 by m split arrays.
+/// zr and zi are work space for a complex row of n2 elements, one per thread.
+struct fft2d
+{
+    int n1, n2, m;
+    fft_plan rows, cols;
+
+    fft2d(int n1, int n2)
+      : n1(n1)
+      , n2(n2)
+      , m(n2 / 2 + 1)
+      , rows(n2)
+      , cols(n1)
+    {}
+
+    /// spectrum (re, im) of the real array given by row(i), which returns row i of n2 floats or
+    /// nullptr for a row of zeros. the row only needs to stay valid until the next call of row().
+    /// two real rows are transformed at once, as the real and imaginary parts of a complex row.
+    template<typename Row>
+    void forward(Row&& row, float* re, float* im, float* zr, float* zi) const
+    {
+        // copy row i to z, returns false if it is all zeros
+        auto load = [&](int i, float* z) {
+            float const* const r = row(i);
+            if (r) {
+                std::copy(r, r + n2, z);
+            } else {
+                std::fill(z, z + n2, 0.0f);
+            }
+            return r != nullptr;
+        };
+
+        for (int i = 0; i < n1; i += 2) {
+            const bool nonzero_a = load(i, zr);
+            const bool nonzero_b = load(i + 1, zi);
+
+            float* const ar = re + i * m;
+            float* const ai = im + i * m;
+            float* const br = re + (i + 1) * m;
+            float* const bi = im + (i + 1) * m;
+
+            if (!nonzero_a && !nonzero_b) {
+                std::fill(ar, ar + m, 0.0f);
+                std::fill(ai, ai + m, 0.0f);
+                std::fill(br, br + m, 0.0f);
+                std::fill(bi, bi + m, 0.0f);
+                continue;
+            }
+
+            rows.transform(zr, zi, 1, false);
+
+            // separate the spectra with their hermitian symmetry:
+            // A[k] = (Z[k] + conj(Z[n2 - k])) / 2, B[k] = (Z[k] - conj(Z[n2 - k])) / 2i
+            for (int k = 0; k < m; k++) {
+                const int kc = (n2 - k) & (n2 - 1);
+                const float pr = zr[k], pi = zi[k];
+                const float qr = zr[kc], qi = -zi[kc];
+
+                ar[k] = 0.5f * (pr + qr);
+                ai[k] = 0.5f * (pi + qi);
+                br[k] = 0.5f * (pi - qi);
+                bi[k] = -0.5f * (pr - qr);
+            }
+        }
+
+        cols.transform(re, im, m, false);
+    }
+
+    /// inverse of forward(), destroys (re, im) and writes the rows [0, n_rows) of the real array,
+    /// scaled by n1 * n2, with out(i, row) where row is an array of n2 floats
+    template<typename Out>
+    void inverse(float* re, float* im, const int n_rows, Out&& out, float* zr, float* zi) const
+    {
+        cols.transform(re, im, m, true);
+
+        for (int i = 0; i < n_rows; i += 2) {
+            float const* const ar = re + i * m;
+            float const* const ai = im + i * m;
+            float const* const br = re + (i + 1) * m;
+            float const* const bi = im + (i + 1) * m;
+
+            // Z = A + iB, with the redundant half of A and B restored from the symmetry
+            for (int k = 0; k < n2; k++) {
+                float a_r, a_i, b_r, b_i;
+
+                if (k < m) {
+                    a_r = ar[k], a_i = ai[k], b_r = br[k], b_i = bi[k];
+                } else {
+                    a_r = ar[n2 - k], a_i = -ai[n2 - k], b_r = br[n2 - k], b_i = -bi[n2 - k];
+                }
+
+                zr[k] = a_r - b_i;
+                zi[k] = a_i + b_r;
+            }
+
+            rows.transform(zr, zi, 1, true);
+
+            out(i, zr);
+            if (i + 1 < n_rows) {
+                out(i + 1, zi);
+            }
+        }
+    }
+};
+
+/// smallest power of 2 that is at least n
+inline int
+next_pow2(int n)
+{
+    int p = 1;
+    while (p < n) {
+        p *= 2;
+    }
+    return p;
+}
+
+/// convolve inp (n1 by n2) with win (nw by nw) like conv() in conv.hpp, with fft.
+///
+/// the result is split into tiles that are computed independently with the overlap-save method:
+/// a tile of l1 by l2 results is the valid part of the circular correlation of an f1 by f2 block
+/// of the input (starting nw / 2 before the tile, zero outside of inp) with the window, where
+/// l = f - nw + 1. unlike overlap-add, no two tiles write the same element of res, so the tiles are
+/// scheduled on the thread pool without synchronization.
+void
+fft_conv(const int n1,
+         const int n2,
+         const int nw,
+         float const* const inp,
+         float const* const win,
+         float* const res)
+{
+    const int h = nw / 2;
+
+    // about 4 times the window in each dimension keeps 3/4 of each tile valid,
+    // but no more than it takes to cover the whole input at once
+    const int f_max = std::max(64, next_pow2(4 * nw));
+    const int f1 = std::max(2, std::min(f_max, next_pow2(n1 + nw - 1)));
+    const int f2 = std::max(2, std::min(f_max, next_pow2(n2 + nw - 1)));
+    const int l1 = f1 - nw + 1;
+    const int l2 = f2 - nw + 1;
+    const int m = f2 / 2 + 1;
+
+    const fft2d tr(f1, f2);
+
+    // spectrum of the window, conjugated since conv() is a correlation
+    std::vector<float> wr(f1 * m), wi(f1 * m);
+    {
+        std::vector<float> row(f2, 0.0f), zr(f2), zi(f2);
+
+        tr.forward(
+          [&](int i) -> float const* {
+              if (i >= nw) {
+                  return nullptr;
+              }
+              std::copy(win + i * nw, win + (i + 1) * nw, row.begin());
+              return row.data();
+          },
+          wr.data(),
+          wi.data(),
+          zr.data(),
+          zi.data());
+
+        // the scaling of the inverse transform is folded into the window
+        const float scale = 1.0f / (static_cast<float>(f1) * f2);
+        for (int k = 0; k < f1 * m; k++) {
+            wr[k] *= scale;
+            wi[k] *= -scale;
+        }
+    }
+
+    const int t1 = (n1 + l1 - 1) / l1;
+    const int t2 = (n2 + l2 - 1) / l2;
+
+    parallel_for(0, t1 * t2, [&](int t) {
+        const int o1 = t / t2 * l1; // first result of the tile
+        const int o2 = t % t2 * l2;
+
+        static thread_local std::vector<float> re, im, row, zr, zi;
+        re.resize(f1 * m);
+        im.resize(f1 * m);
+        row.resize(f2);
+        zr.resize(f2);
+        zi.resize(f2);
+
+        // row i of the input block, input row o1 - h + i from column o2 - h
+        const int c0 = std::max(0, o2 - h);
+        const int c1 = std::min(n2, o2 - h + f2);
+
+        tr.forward(
+          [&](int i) -> float const* {
+              const int r = o1 - h + i;
+              if (r < 0 || r >= n1) {
+                  return nullptr;
+              }
+              std::fill(row.begin(), row.end(), 0.0f);
+              std::copy(inp + r * n2 + c0, inp + r * n2 + c1, row.begin() + (c0 - (o2 - h)));
+              return row.data();
+          },
+          re.data(),
+          im.data(),
+          zr.data(),
+          zi.data());
+
+        for (int k = 0; k < f1 * m; k++) {
+            const float a = re[k], b = im[k];
+
+            re[k] = a * wr[k] - b * wi[k];
+            im[k] = a * wi[k] + b * wr[k];
+        }
+
+        const int r1 = std::min(l1, n1 - o1);
+        const int r2 = std::min(l2, n2 - o2);
+
+        tr.inverse(
+          re.data(),
+          im.data(),
+          r1,
+          [&](int i, float const* out) { std::copy(out, out + r2, res + (o1 + i) * n2 + o2); },
+          zr.data(),
+          zi.data());
+    });
+}
+
+} // namespace
+
+} // namespace cmpe492
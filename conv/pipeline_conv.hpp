@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "direct_conv.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+// a chain of convolutions computed tile by tile, without storing the results between them.
+
+namespace cmpe492 {
+
+namespace {
+
+/// rows and columns of the result in a tile of pipeline_conv(). the two buffers of a tile take
+/// about 600 kb, which stay in the l2 cache. tiles of 256 columns or less were slower than the
+/// calls of conv() they replace, the short pieces of rows they read defeat the prefetcher, and
+/// fewer rows recompute more of the halos.
+constexpr int pipeline_tile_rows = 64;
+constexpr int pipeline_tile_cols = 1024;
+
+/// convolve inp (n1 by n2) with the windows of the stages in turn, like conv_pipeline() in
+/// conv.hpp, with the direct kernel.
+///
+/// each task takes a tile of the result and copies the input it depends on, the tile with a halo
+/// of the nw / 2 of all the stages around it, to a buffer. every stage then computes its results
+/// for the tile with the halo of the stages after it from one buffer into the other, so a tile
+/// goes through all the stages in the cache, and only the input and the result are in memory.
+/// the results of a stage out of the image are set to 0, which is the padding the next stage
+/// would see.
+template<typename vector_t, int rows, int nv>
+void
+pipeline_conv(const int n1,
+              const int n2,
+              const int n_stages,
+              int const* const nws,
+              float const* const* const wins,
+              float const* const inp,
+              float* const res)
+{
+    constexpr int vw = sizeof(vector_t) / sizeof(float);
+
+    if (n_stages == 0) {
+        std::copy(inp, inp + n1 * n2, res);
+        return;
+    }
+
+    // halo[s] is the rows and columns around the tile that the input of stage s covers
+    std::vector<int> halo(n_stages + 1, 0);
+    for (int s = n_stages - 1; s >= 0; s--) {
+        halo[s] = halo[s + 1] + nws[s] / 2;
+    }
+
+    // the whole vectors of a stage read up to vw - 1 columns past its input
+    const int ld = pipeline_tile_cols + 2 * halo[0] + vw;
+    const int buf_rows = pipeline_tile_rows + 2 * halo[0];
+
+    const int tiles1 = (n1 + pipeline_tile_rows - 1) / pipeline_tile_rows;
+    const int tiles2 = (n2 + pipeline_tile_cols - 1) / pipeline_tile_cols;
+
+    parallel_for(0, tiles1 * tiles2, [&](int t) {
+        const int i0 = t / tiles2 * pipeline_tile_rows;
+        const int c0 = t % tiles2 * pipeline_tile_cols;
+        const int t_rows = std::min(pipeline_tile_rows, n1 - i0);
+        const int t_cols = std::min(pipeline_tile_cols, n2 - c0);
+
+        static thread_local std::vector<float> buf;
+        buf.resize(2 * buf_rows * ld);
+
+        float* a = buf.data();
+        float* b = a + buf_rows * ld;
+
+        // the input of the stage, from row i0 - halo[s] and column c0 - halo[s], rows ld_src
+        // apart. the first stage reads inp in place if the input of the tile and the vectors
+        // past it are within inp, otherwise a padded copy.
+        float const* src = a;
+        int ld_src = ld;
+
+        if (i0 >= halo[0] && i0 + t_rows + halo[0] <= n1 && c0 >= halo[0] &&
+            c0 + t_cols + halo[0] + vw <= n2) {
+            src = inp + (i0 - halo[0]) * n2 + (c0 - halo[0]);
+            ld_src = n2;
+        } else {
+            fill_strip(i0 - halo[0], t_rows + 2 * halo[0], c0 - halo[0], ld, n1, n2, inp, a);
+        }
+
+        for (int s = 0; s < n_stages; s++) {
+            const int nw = nws[s];
+            const int h = halo[s + 1];
+            const int m_rows = t_rows + 2 * h;
+            const int len = (t_cols + 2 * h + vw - 1) / vw * vw;
+
+            // the last stage writes to res directly, unless its vectors would pass the tile
+            const bool last = (s + 1 == n_stages);
+            const bool in_place = last && len == t_cols;
+
+            float* const dst = in_place ? res + i0 * n2 + c0 : b;
+            const int ld_dst = in_place ? n2 : ld;
+
+            int r = 0;
+            for (; r + rows <= m_rows; r += rows) {
+                direct_block<vector_t, rows, nv>(
+                  0, len, nw, src + r * ld_src, ld_src, 0, wins[s], dst + r * ld_dst, ld_dst);
+            }
+            for (; r < m_rows; r++) {
+                direct_block<vector_t, 1, nv>(
+                  0, len, nw, src + r * ld_src, ld_src, 0, wins[s], dst + r * ld_dst, ld_dst);
+            }
+
+            if (!last) {
+                const int lo = std::clamp(-(c0 - h), 0, t_cols + 2 * h);
+                const int hi = std::clamp(n2 - (c0 - h), lo, t_cols + 2 * h);
+
+                for (r = 0; r < m_rows; r++) {
+                    float* const row = b + r * ld;
+                    const int i = i0 - h + r;
+
+                    if (i < 0 || i >= n1) {
+                        std::fill(row, row + t_cols + 2 * h, 0.0f);
+                    } else {
+                        std::fill(row, row + lo, 0.0f);
+                        std::fill(row + hi, row + t_cols + 2 * h, 0.0f);
+                    }
+                }
+            } else if (!in_place) {
+                for (r = 0; r < t_rows; r++) {
+                    std::copy(b + r * ld, b + r * ld + t_cols, res + (i0 + r) * n2 + c0);
+                }
+            }
+
+            src = b;
+            ld_src = ld;
+            std::swap(a, b);
+        }
+    });
+}
+
+} // namespace
+
+} // namespace cmpe492
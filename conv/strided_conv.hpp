@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+// strided and dilated convolution, which computes only the results it keeps.
+
+namespace cmpe492 {
+
+namespace {
+
+/// rows consecutive rows of the result, the columns [j0, j1), a whole number of vectors.
+/// window row k1 of result row r reads the row src[r * nw + k1], where window column k2 of the
+/// result j is the element off[k2] + j. the result rows are ldo apart.
+///
+/// nv vectors of consecutive results of each row are kept in registers, and an element of the
+/// window is broadcast once for the rows of the block.
+template<typename vector_t, int rows, int nv>
+void
+strided_block(const int j0,
+              const int j1,
+              const int nw,
+              float const* const* const src,
+              int const* const off,
+              float const* const __restrict win,
+              float* const __restrict out,
+              const int ldo)
+{
+    constexpr int vw = sizeof(vector_t) / sizeof(float);
+    using vector_unalgn_t = typename vector_of<vw>::unalgn_type;
+
+    // computes the results [j, j + n * vw) of the block
+    auto vectors = [&](auto n_tag, const int j) {
+        constexpr int n = decltype(n_tag)::value;
+
+        vector_t acc[rows][n] = {};
+
+        for (int k1 = 0; k1 < nw; k1++) {
+            float const* s[rows];
+            for (int r = 0; r < rows; r++) {
+                s[r] = src[r * nw + k1] + j;
+            }
+
+            for (int k2 = 0; k2 < nw; k2++) {
+                const float w = win[k1 * nw + k2];
+                const int o = off[k2];
+
+#pragma GCC unroll 8
+                for (int r = 0; r < rows; r++) {
+#pragma GCC unroll 4
+                    for (int v = 0; v < n; v++) {
+                        acc[r][v] += w * *reinterpret_cast<vector_unalgn_t const*>(
+                                           s[r] + o + v * vw);
+                    }
+                }
+            }
+        }
+
+        for (int r = 0; r < rows; r++) {
+            for (int v = 0; v < n; v++) {
+                *reinterpret_cast<vector_unalgn_t*>(&out[r * ldo + j + v * vw]) = acc[r][v];
+            }
+        }
+    };
+
+    int j = j0;
+    for (; j + nv * vw <= j1; j += nv * vw) {
+        vectors(std::integral_constant<int, nv>{}, j);
+    }
+    for (; j + vw <= j1; j += vw) {
+        vectors(std::integral_constant<int, 1>{}, j);
+    }
+}
+
+/// split the row in, of n2 elements, into the s2 parts of dst, pw apart: element t of part p is
+/// in[(t - lead) * s2 + p], or 0 out of in
+inline void
+strided_split(float const* const in,
+              const int n2,
+              const int s2,
+              const int lead,
+              const int pw,
+              float* const dst)
+{
+    // the elements up to full have all their parts in the input. they are read in order, with
+    // the stride known at compile time for the common ones, which gcc vectorizes with shuffles.
+    const int full = n2 / s2;
+
+    auto split = [&](auto s_tag, const int s) {
+        constexpr int sc = decltype(s_tag)::value;
+        const int st = sc ? sc : s;
+
+        for (int t = 0; t < full; t++) {
+            for (int p = 0; p < st; p++) {
+                dst[p * pw + lead + t] = in[t * st + p];
+            }
+        }
+    };
+
+    switch (s2) {
+        case 1:
+            std::copy(in, in + n2, dst + lead);
+            break;
+        case 2:
+            split(std::integral_constant<int, 2>{}, 2);
+            break;
+        case 4:
+            split(std::integral_constant<int, 4>{}, 4);
+            break;
+        default:
+            split(std::integral_constant<int, 0>{}, s2);
+    }
+
+    for (int p = 0; p < s2; p++) {
+        float* const part = dst + p * pw;
+        const int end = lead + (n2 - p + s2 - 1) / s2; // past the last element from the input
+
+        if (end > lead + full) {
+            part[lead + full] = in[full * s2 + p];
+        }
+
+        std::fill(part, part + lead, 0.0f);
+        std::fill(part + std::min(end, pw), part + pw, 0.0f);
+    }
+}
+
+/// convolve inp (n1 by n2) with win (nw by nw) dilated by (d1, d2), at the results (i * s1,
+/// j * s2) only, like conv_strided() in conv.hpp.
+///
+/// the result is split into tasks of task_rows rows. a task first copies the input rows it needs
+/// to a strip, each with its columns split by their remainder modulo s2 into s2 parts, with
+/// zeros around the input. window column k2 of consecutive results then reads consecutive
+/// elements of one part, so the results are vectorized like in direct_block().
+template<typename vector_t, int rows, int nv>
+void
+strided_conv(const int n1,
+             const int n2,
+             const int nw,
+             const int s1,
+             const int s2,
+             const int d1,
+             const int d2,
+             float const* const inp,
+             float const* const win,
+             float* const res,
+             const int task_rows)
+{
+    constexpr int vw = sizeof(vector_t) / sizeof(float);
+
+    const int h = nw / 2;
+    const int m1 = (n1 + s1 - 1) / s1;
+    const int m2 = (n2 + s2 - 1) / s2;
+    const int len = (m2 + vw - 1) / vw * vw; // results of a row, in whole vectors
+
+    // element t of part p of a row of the strip is input column (t - lead) * s2 + p, and window
+    // column k2 of result j is element off[k2] + j of the row
+    const int lead = (d2 * h + s2 - 1) / s2;
+    const int pw = len + (d2 * h + lead * s2) / s2;
+
+    std::vector<int> off(nw);
+    for (int k2 = 0; k2 < nw; k2++) {
+        const int c = d2 * (k2 - h) + lead * s2;
+        off[k2] = c % s2 * pw + c / s2;
+    }
+
+    const int tasks = (m1 + task_rows - 1) / task_rows;
+
+    parallel_for(0, tasks, [&](int t) {
+        const int i0 = t * task_rows;
+        const int i1 = std::min(i0 + task_rows, m1);
+
+        // the input rows [lo, lo + n_rows) may be read by the task, only those that are get
+        // copied. the rows out of inp read a row of zeros, after the others.
+        const int lo = i0 * s1 - d1 * h;
+        const int n_rows = (i1 - 1 - i0) * s1 + 2 * d1 * h + 1;
+        const int ld = s2 * pw;
+
+        static thread_local std::vector<float> strip;
+        static thread_local std::vector<char> copied;
+        static thread_local std::vector<float const*> src;
+
+        strip.resize((n_rows + 1) * ld + rows * len);
+        copied.assign(n_rows, 0);
+        src.resize(rows * nw);
+
+        float* const zeros = strip.data() + n_rows * ld;
+        float* const out = zeros + ld;
+        std::fill(zeros, zeros + ld, 0.0f);
+
+        // the strip row of input row i
+        auto row = [&](const int i) -> float const* {
+            if (i < 0 || i >= n1) {
+                return zeros;
+            }
+
+            float* const dst = strip.data() + (i - lo) * ld;
+
+            if (!copied[i - lo]) {
+                copied[i - lo] = 1;
+                strided_split(inp + i * n2, n2, s2, lead, pw, dst);
+            }
+
+            return dst;
+        };
+
+        // the results of the rows [i, i + r_rows), in whole vectors into out and then copied
+        auto block = [&](auto rows_tag, const int i) {
+            constexpr int r_rows = decltype(rows_tag)::value;
+
+            for (int r = 0; r < r_rows; r++) {
+                for (int k1 = 0; k1 < nw; k1++) {
+                    src[r * nw + k1] = row((i + r) * s1 + d1 * (k1 - h));
+                }
+            }
+
+            strided_block<vector_t, r_rows, nv>(0, len, nw, src.data(), off.data(), win, out, len);
+
+            for (int r = 0; r < r_rows; r++) {
+                std::copy(out + r * len, out + r * len + m2, res + (i + r) * m2);
+            }
+        };
+
+        int i = i0;
+        for (; i + rows <= i1; i += rows) {
+            block(std::integral_constant<int, rows>{}, i);
+        }
+        for (; i < i1; i++) {
+            block(std::integral_constant<int, 1>{}, i);
+        }
+    });
+}
+
+} // namespace
+
+} // namespace cmpe492
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <tuple>
 #include <vector>
@@ -5,13 +7,16 @@
 #include "conv.hpp"
 #include "generator.hpp"
 
+/// the error is divided by nw, or with relative set, by the magnitude of the expected result,
+/// which suits large windows whose sums grow with nw * nw
 bool
 test_conv(int n1,
           int n2,
           int nw,
           std::vector<float> inp,
           std::vector<float> win,
-          std::vector<float> expected_res)
+          std::vector<float> expected_res,
+          bool relative = false)
 {
     std::vector<float> res(n1 * n2);
 
@@ -22,7 +27,8 @@ test_conv(int n1,
             return false;
         }
 
-        auto err = std::abs((res[i] - expected_res[i]) / nw);
+        auto err = std::abs(res[i] - expected_res[i]) /
+                   (relative ? std::max(1.0f, std::abs(expected_res[i])) : nw);
 
         if (err > 1e-5) {
             return false;
@@ -47,8 +53,9 @@ hardcoded_test_cases()
                { 0.72, 1.43, 1.78, 1.66, 1.71, 3.08, 3.53, 2.88, 1.41, 2.14, 2.39, 1.49 } } };
 }
 
+/// a random test case, whose window is the outer product of two random vectors if separable is set
 test_case
-generate_random_test_case(int n1, int n2, int nw)
+generate_random_test_case(int n1, int n2, int nw, bool separable = false)
 {
     std::vector<float> inp(n1 * n2);
     std::vector<float> win(nw * nw);
@@ -56,10 +63,26 @@ generate_random_test_case(int n1, int n2, int nw)
     cmpe492::random_fill(inp.begin(), inp.end());
     cmpe492::random_fill(win.begin(), win.end());
 
+    if (separable) {
+        std::vector<float> col(nw), row(nw);
+
+        cmpe492::random_fill(col.begin(), col.end());
+        cmpe492::random_fill(row.begin(), row.end());
+
+        for (int k1 = 0; k1 < nw; k1++) {
+            for (int k2 = 0; k2 < nw; k2++) {
+                win[k1 * nw + k2] = col[k1] * row[k2];
+            }
+        }
+    }
+
     std::vector<float> expected(n1 * n2);
 
+    // accumulated in double, so that the reference stays accurate for large windows
     for (int i = 0; i < n1; i++) {
         for (int j = 0; j < n2; j++) {
+            double t = 0;
+
             for (int k1 = 0; k1 < nw; k1++) {
                 for (int k2 = 0; k2 < nw; k2++) {
 
@@ -67,16 +90,64 @@ generate_random_test_case(int n1, int n2, int nw)
                     int jj = j + k2 - nw / 2;
 
                     if (ii >= 0 && ii < n1 && jj >= 0 && jj < n2) {
-                        expected[i * n2 + j] += inp[ii * n2 + jj] * win[k1 * nw + k2];
+                        t += (double)inp[ii * n2 + jj] * win[k1 * nw + k2];
                     }
                 }
             }
+
+            expected[i * n2 + j] = t;
         }
     }
 
     return { n1, n2, nw, inp, win, expected };
 }
 
+#ifdef CMPE492_TEST_STRIDED
+/// compare conv_strided() with conv() of the dilated window at full resolution, subsampled.
+/// the dilated window is large and mostly zeros, so the error is relative as for large windows.
+bool
+test_strided(int n1, int n2, int nw, int s1, int s2, int d1, int d2)
+{
+    const int nd = (nw - 1) * std::max(d1, d2) + 1; // side of the dilated window
+    const int m1 = (n1 + s1 - 1) / s1;
+    const int m2 = (n2 + s2 - 1) / s2;
+
+    std::vector<float> inp(n1 * n2);
+    std::vector<float> win(nw * nw);
+    std::vector<float> dilated(nd * nd, 0.0f);
+    std::vector<float> full(n1 * n2);
+    std::vector<float> res(m1 * m2);
+
+    cmpe492::random_fill(inp.begin(), inp.end());
+    cmpe492::random_fill(win.begin(), win.end());
+
+    for (int k1 = 0; k1 < nw; k1++) {
+        for (int k2 = 0; k2 < nw; k2++) {
+            int r = nd / 2 + d1 * (k1 - nw / 2);
+            int c = nd / 2 + d2 * (k2 - nw / 2);
+
+            dilated[r * nd + c] = win[k1 * nw + k2];
+        }
+    }
+
+    cmpe492::conv(n1, n2, nd, inp.data(), dilated.data(), full.data());
+    cmpe492::conv_strided(n1, n2, nw, s1, s2, d1, d2, inp.data(), win.data(), res.data());
+
+    for (int i = 0; i < m1; i++) {
+        for (int j = 0; j < m2; j++) {
+            float r = res[i * m2 + j];
+            float e = full[i * s1 * n2 + j * s2];
+
+            if (r != r || std::abs(r - e) / std::max(1.0f, std::abs(e)) > 1e-5) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+#endif
+
 auto
 random_test_sizes()
 {
@@ -149,6 +220,66 @@ main(int argc, char* argv[])
         }
     }
 
+    // separable windows, which the optimized versions convolve in two 1d passes
+    for (auto [n1, n2, nw] : { std::tuple{ 50, 53, 3 },
+                               std::tuple{ 101, 100, 5 },
+                               std::tuple{ 100, 103, 15 },
+                               std::tuple{ 75, 90, 31 },
+                               std::tuple{ 10, 7, 15 } }) {
+        std::cout << n1 << " " << n2 << " " << nw << " separable " << std::flush;
+
+        auto [_n1, _n2, _nw, inp, win, expected_res] =
+          generate_random_test_case(n1, n2, nw, true);
+
+        bool ok = test_conv(n1, n2, nw, inp, win, expected_res);
+
+        std::cout << (ok ? "[ok]" : "[failed]") << std::endl;
+
+        if (!ok) {
+            ever_failed = true;
+        }
+    }
+
+    // large windows, which conv_fft and the fft path of the optimized versions are for
+    for (auto [n1, n2, nw] : { std::tuple{ 100, 103, 45 },
+                               std::tuple{ 257, 300, 31 },
+                               std::tuple{ 64, 200, 63 },
+                               std::tuple{ 20, 9, 45 } }) {
+        std::cout << n1 << " " << n2 << " " << nw << " " << std::flush;
+
+        auto [_n1, _n2, _nw, inp, win, expected_res] = generate_random_test_case(n1, n2, nw);
+
+        bool ok = test_conv(n1, n2, nw, inp, win, expected_res, true);
+
+        std::cout << (ok ? "[ok]" : "[failed]") << std::endl;
+
+        if (!ok) {
+            ever_failed = true;
+        }
+    }
+
+#ifdef CMPE492_TEST_STRIDED
+    // strided and dilated convolution, n1, n2, nw, s1, s2, d1, d2
+    int strided[][7] = { { 50, 53, 3, 2, 2, 1, 1 },  { 101, 100, 5, 2, 2, 2, 2 },
+                         { 64, 67, 7, 4, 4, 1, 1 },  { 33, 120, 3, 1, 3, 1, 2 },
+                         { 40, 45, 1, 3, 2, 1, 1 },  { 100, 37, 3, 1, 1, 4, 4 },
+                         { 9, 70, 5, 2, 1, 3, 1 },   { 3, 2, 7, 2, 3, 2, 1 },
+                         { 128, 96, 11, 2, 2, 1, 1 } };
+
+    for (auto [n1, n2, nw, s1, s2, d1, d2] : strided) {
+        std::cout << n1 << " " << n2 << " " << nw << " stride " << s1 << " " << s2
+                  << " dilation " << d1 << " " << d2 << " " << std::flush;
+
+        bool ok = test_strided(n1, n2, nw, s1, s2, d1, d2);
+
+        std::cout << (ok ? "[ok]" : "[failed]") << std::endl;
+
+        if (!ok) {
+            ever_failed = true;
+        }
+    }
+#endif
+
     if (ever_failed) {
         std::cout << "There are failing tests!" << std::endl;
     }
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "conv_layer.hpp"
+#include "generator.hpp"
+
+/// compare conv_layer() with the sum of the direct convolutions of the input channels.
+/// the error is relative to the magnitude of the result, whose sums grow with c_in * nw * nw.
+bool
+test_layer(int n, int c_in, int c_out, int h, int w, int nw)
+{
+    std::vector<float> inp(n * c_in * h * w);
+    std::vector<float> filters(c_out * c_in * nw * nw);
+    std::vector<float> res(n * c_out * h * w);
+
+    cmpe492::random_fill(inp.begin(), inp.end());
+    cmpe492::random_fill(filters.begin(), filters.end());
+
+    cmpe492::conv_layer(n, c_in, c_out, h, w, nw, inp.data(), filters.data(), res.data());
+
+    for (int b = 0; b < n; b++) {
+        for (int co = 0; co < c_out; co++) {
+            for (int i = 0; i < h; i++) {
+                for (int j = 0; j < w; j++) {
+                    double expected = 0;
+
+                    for (int ci = 0; ci < c_in; ci++) {
+                        for (int k1 = 0; k1 < nw; k1++) {
+                            for (int k2 = 0; k2 < nw; k2++) {
+                                int ii = i + k1 - nw / 2;
+                                int jj = j + k2 - nw / 2;
+
+                                if (ii >= 0 && ii < h && jj >= 0 && jj < w) {
+                                    expected += (double)inp[((b * c_in + ci) * h + ii) * w + jj] *
+                                                filters[((co * c_in + ci) * nw + k1) * nw + k2];
+                                }
+                            }
+                        }
+                    }
+
+                    float r = res[((b * c_out + co) * h + i) * w + j];
+                    double err = std::abs(r - expected) / std::max(1.0, std::abs(expected));
+
+                    if (r != r || err > 1e-5) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+int
+main()
+{
+    bool ever_failed = false;
+
+    // n, c_in, c_out, h, w, nw
+    int shapes[][6] = { { 1, 1, 1, 1, 1, 1 },   { 2, 3, 5, 7, 9, 3 },    { 1, 4, 17, 33, 20, 5 },
+                        { 3, 2, 8, 16, 16, 1 }, { 1, 16, 3, 50, 41, 7 }, { 2, 3, 4, 5, 3, 7 },
+                        { 1, 8, 33, 12, 130, 3 }, { 1, 64, 8, 40, 64, 3 } };
+
+    for (auto [n, c_in, c_out, h, w, nw] : shapes) {
+        std::cout << n << " " << c_in << " " << c_out << " " << h << " " << w << " " << nw << " "
+                  << std::flush;
+
+        bool ok = test_layer(n, c_in, c_out, h, w, nw);
+
+        std::cout << (ok ? "[ok]" : "[failed]") << std::endl;
+
+        if (!ok) {
+            ever_failed = true;
+        }
+    }
+
+    if (ever_failed) {
+        std::cout << "There are failing tests!" << std::endl;
+    }
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
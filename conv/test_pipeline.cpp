@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "conv.hpp"
+#include "generator.hpp"
+
+/// compare conv_pipeline() with conv() called once per stage on the result of the previous one.
+/// the error is relative to the magnitude of the result, which grows with every stage.
+bool
+test_pipeline(int n1, int n2, std::vector<int> nws)
+{
+    const int n_stages = nws.size();
+
+    std::vector<float> inp(n1 * n2);
+    std::vector<std::vector<float>> wins(n_stages);
+    std::vector<float const*> win_ptrs(n_stages);
+
+    cmpe492::random_fill(inp.begin(), inp.end());
+
+    for (int s = 0; s < n_stages; s++) {
+        wins[s].resize(nws[s] * nws[s]);
+        cmpe492::random_fill(wins[s].begin(), wins[s].end());
+        win_ptrs[s] = wins[s].data();
+    }
+
+    std::vector<float> expected = inp, tmp(n1 * n2);
+    for (int s = 0; s < n_stages; s++) {
+        cmpe492::conv(n1, n2, nws[s], expected.data(), wins[s].data(), tmp.data());
+        std::swap(expected, tmp);
+    }
+
+    std::vector<float> res(n1 * n2);
+    cmpe492::conv_pipeline(n1, n2, n_stages, nws.data(), win_ptrs.data(), inp.data(), res.data());
+
+    for (int i = 0; i < n1 * n2; i++) {
+        float err = std::abs(res[i] - expected[i]) / std::max(1.0f, std::abs(expected[i]));
+
+        if (res[i] != res[i] || err > 1e-5) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int
+main()
+{
+    bool ever_failed = false;
+
+    // n1, n2, windows of the stages
+    std::vector<std::tuple<int, int, std::vector<int>>> cases = {
+        { 50, 53, {} },
+        { 1, 1, { 3, 3 } },
+        { 7, 5, { 5, 3, 7 } },
+        { 100, 103, { 3 } },
+        { 100, 103, { 5, 3, 3 } },
+        { 64, 256, { 3, 3, 3, 3, 3 } },
+        { 130, 300, { 7, 1, 5 } },
+        { 257, 520, { 3, 5, 3, 5 } },
+        { 33, 700, { 11, 9 } },
+        { 200, 2100, { 3 } },
+        { 300, 2500, { 5, 3, 3 } },
+        { 150, 2051, { 7, 3 } },
+    };
+
+    for (auto& [n1, n2, nws] : cases) {
+        std::cout << n1 << " " << n2 << " [";
+        for (size_t s = 0; s < nws.size(); s++) {
+            std::cout << (s ? " " : "") << nws[s];
+        }
+        std::cout << "] " << std::flush;
+
+        bool ok = test_pipeline(n1, n2, nws);
+
+        std::cout << (ok ? "[ok]" : "[failed]") << std::endl;
+
+        if (!ok) {
+            ever_failed = true;
+        }
+    }
+
+    if (ever_failed) {
+        std::cout << "There are failing tests!" << std::endl;
+    }
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <cmath>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+#include "conv.hpp"
+#include "generator.hpp"
+
+/// compare conv_separable() with the direct convolution by the outer product of col and row
+bool
+test_separable(int n1, int n2, int nw)
+{
+    std::vector<float> inp(n1 * n2);
+    std::vector<float> col(nw), row(nw);
+
+    cmpe492::random_fill(inp.begin(), inp.end());
+    cmpe492::random_fill(col.begin(), col.end());
+    cmpe492::random_fill(row.begin(), row.end());
+
+    std::vector<float> res(n1 * n2);
+    cmpe492::conv_separable(n1, n2, nw, inp.data(), col.data(), row.data(), res.data());
+
+    for (int i = 0; i < n1; i++) {
+        for (int j = 0; j < n2; j++) {
+            double expected = 0;
+
+            for (int k1 = 0; k1 < nw; k1++) {
+                for (int k2 = 0; k2 < nw; k2++) {
+                    int ii = i + k1 - nw / 2;
+                    int jj = j + k2 - nw / 2;
+
+                    if (ii >= 0 && ii < n1 && jj >= 0 && jj < n2) {
+                        expected += (double)inp[ii * n2 + jj] * col[k1] * row[k2];
+                    }
+                }
+            }
+
+            float r = res[i * n2 + j];
+
+            if (r != r || std::abs((r - expected) / nw) > 1e-5) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int
+main()
+{
+    bool ever_failed = false;
+
+    for (int nw : { 1, 3, 5, 15, 31 }) {
+        for (auto [n1, n2] : { std::tuple{ 1, 1 },
+                               std::tuple{ 7, 9 },
+                               std::tuple{ 33, 64 },
+                               std::tuple{ 100, 101 },
+                               std::tuple{ 130, 17 } }) {
+            std::cout << n1 << " " << n2 << " " << nw << " " << std::flush;
+
+            bool ok = test_separable(n1, n2, nw);
+
+            std::cout << (ok ? "[ok]" : "[failed]") << std::endl;
+
+            if (!ok) {
+                ever_failed = true;
+            }
+        }
+    }
+
+    if (ever_failed) {
+        std::cout << "There are failing tests!" << std::endl;
+    }
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
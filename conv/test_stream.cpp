@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "conv_stream.hpp"
+#include "generator.hpp"
+
+/// feed an n1 by n2 image to a conv_stream in chunks of chunk rows (the last one shorter) and
+/// compare the rows it writes with the direct convolution. also checks that every row of the
+/// result is written as soon as the input rows it needs are in, and that the stream can be reused.
+bool
+test_stream(int n1, int n2, int nw, int chunk)
+{
+    std::vector<float> inp(n1 * n2);
+    std::vector<float> win(nw * nw);
+    std::vector<float> res(n1 * n2);
+
+    cmpe492::random_fill(inp.begin(), inp.end());
+    cmpe492::random_fill(win.begin(), win.end());
+
+    cmpe492::conv_stream stream(n2, nw, win.data());
+
+    for (int pass = 0; pass < 2; pass++) {
+        std::fill(res.begin(), res.end(), NAN);
+
+        int written = 0;
+
+        for (int i = 0; i < n1; i += chunk) {
+            const int rows = std::min(chunk, n1 - i);
+
+            written += stream.push(rows, &inp[i * n2], &res[written * n2]);
+
+            if (written != std::max(0, i + rows - nw / 2)) {
+                return false;
+            }
+        }
+
+        written += stream.finish(&res[written * n2]);
+
+        if (written != n1 || stream.rows_done() != n1) {
+            return false;
+        }
+
+        for (int i = 0; i < n1; i++) {
+            for (int j = 0; j < n2; j++) {
+                double expected = 0;
+
+                for (int k1 = 0; k1 < nw; k1++) {
+                    for (int k2 = 0; k2 < nw; k2++) {
+                        int ii = i + k1 - nw / 2;
+                        int jj = j + k2 - nw / 2;
+
+                        if (ii >= 0 && ii < n1 && jj >= 0 && jj < n2) {
+                            expected += (double)inp[ii * n2 + jj] * win[k1 * nw + k2];
+                        }
+                    }
+                }
+
+                float r = res[i * n2 + j];
+
+                if (r != r || std::abs(r - expected) / nw > 1e-5) {
+                    return false;
+                }
+            }
+        }
+
+        stream.reset();
+    }
+
+    return true;
+}
+
+int
+main()
+{
+    bool ever_failed = false;
+
+    // n1, n2, nw, chunk
+    int shapes[][4] = { { 1, 1, 1, 1 },     { 1, 5, 3, 1 },     { 2, 9, 7, 1 },
+                        { 10, 10, 3, 1 },   { 10, 10, 3, 3 },   { 10, 10, 3, 100 },
+                        { 50, 33, 5, 7 },   { 64, 64, 11, 4 },  { 100, 17, 9, 13 },
+                        { 37, 100, 15, 2 }, { 200, 70, 7, 64 }, { 5, 300, 21, 2 } };
+
+    for (auto [n1, n2, nw, chunk] : shapes) {
+        std::cout << n1 << " " << n2 << " " << nw << " " << chunk << " " << std::flush;
+
+        bool ok = test_stream(n1, n2, nw, chunk);
+
+        std::cout << (ok ? "[ok]" : "[failed]") << std::endl;
+
+        if (!ok) {
+            ever_failed = true;
+        }
+    }
+
+    if (ever_failed) {
+        std::cout << "There are failing tests!" << std::endl;
+    }
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+#include "conv.hpp"
+#include "conv_tuning.hpp"
+#include "generator.hpp"
+#include "tuning.hpp"
+
+namespace {
+
+/// best running time of a few calls, in seconds
+double
+measure(int n1, int n2, int nw, float const* inp, float const* win, float* res)
+{
+    using clock = std::chrono::steady_clock;
+
+    cmpe492::conv(n1, n2, nw, inp, win, res); // warm up
+
+    double best = 1e100;
+    for (int r = 0; r < 3; r++) {
+        const auto start = clock::now();
+        cmpe492::conv(n1, n2, nw, inp, win, res);
+        best = std::min(best, std::chrono::duration<double>(clock::now() - start).count());
+    }
+
+    return best;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    using tup3 = std::tuple<int, int, int>;
+    std::vector<tup3> shapes;
+
+    if (argc == 1) {
+        shapes = { { 1000, 1000, 7 }, { 2000, 2000, 7 }, { 2000, 2000, 9 } };
+    } else if (argc % 3 == 1) {
+        for (int i = 1; i < argc; i += 3) {
+            shapes.emplace_back(std::atoi(argv[i]), std::atoi(argv[i + 1]), std::atoi(argv[i + 2]));
+        }
+    } else {
+        std::cout << "usage: " << argv[0] << " [n1 n2 nw]..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto& cache = cmpe492::tuning_cache::instance();
+
+    std::cout << "cpu: " << cmpe492::cpu_model() << "\nkernel: " << cmpe492::conv_tuning_name()
+              << "\ncache: " << cache.path() << std::endl;
+
+    std::vector<cmpe492::conv_config> candidates;
+    for (int block : { 1, 2, 3, 4 }) {
+        for (int rows : { 0, 4, 16, 64 }) {
+            candidates.push_back({ block, rows });
+        }
+    }
+
+    for (auto [n1, n2, nw] : shapes) {
+        std::vector<float> inp(n1 * n2);
+        std::vector<float> win(nw * nw);
+        std::vector<float> res(n1 * n2);
+
+        cmpe492::random_fill(inp.begin(), inp.end());
+        cmpe492::random_fill(win.begin(), win.end());
+
+        const cmpe492::conv_config current = cmpe492::conv_get_config(n1, n2, nw);
+        const double current_time = measure(n1, n2, nw, inp.data(), win.data(), res.data());
+
+        cmpe492::conv_config best = current;
+        double best_time = current_time;
+
+        for (auto const& cfg : candidates) {
+            cmpe492::conv_force_config(&cfg);
+            const double t = measure(n1, n2, nw, inp.data(), win.data(), res.data());
+
+            if (t < best_time) {
+                best = cfg;
+                best_time = t;
+            }
+        }
+        cmpe492::conv_force_config(nullptr);
+
+        std::cout << std::setprecision(4) << std::fixed << n1 << " " << n2 << " " << nw
+                  << "\tblock rows: " << best.block << " " << best.rows << "\t" << best_time
+                  << " s (was " << current_time << " s)" << std::endl;
+
+        const cmpe492::tuning_cache::shape_t shape = { cmpe492::size_class(n1),
+                                                       cmpe492::size_class(n2),
+                                                       nw };
+
+        if (!cache.store(cmpe492::conv_tuning_name(), shape, { best.block, best.rows })) {
+            std::cout << "cannot write " << cache.path() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+// convolution with the winograd minimal filtering algorithms F(4x4, 3x3) and F(2x2, 5x5).
+
+namespace cmpe492 {
+
+namespace {
+
+/// the matrices of F(m, r), which computes m results of a 1d correlation with a window of r from
+/// a = m + r - 1 inputs: y = at * ((g * w) . (bt * d)), where . is the elementwise product.
+/// both algorithms below use the points 0, 1, -1, 2, -2 and infinity, which keeps the constants
+/// small and the rounding errors within those of the direct kernel.
+template<int m, int r>
+struct winograd_matrices;
+
+template<>
+struct winograd_matrices<4, 3>
+{
+    static constexpr float bt[6][6] = {
+        { 4, 0, -5, 0, 1, 0 },  { 0, -4, -4, 1, 1, 0 }, { 0, 4, -4, -1, 1, 0 },
+        { 0, -2, -1, 2, 1, 0 }, { 0, 2, -1, -2, 1, 0 }, { 0, 4, 0, -5, 0, 1 },
+    };
+
+    static constexpr double g[6][3] = {
+        { 1.0 / 4, 0, 0 },
+        { -1.0 / 6, -1.0 / 6, -1.0 / 6 },
+        { -1.0 / 6, 1.0 / 6, -1.0 / 6 },
+        { 1.0 / 24, 1.0 / 12, 1.0 / 6 },
+        { 1.0 / 24, -1.0 / 12, 1.0 / 6 },
+        { 0, 0, 1 },
+    };
+
+    static constexpr float at[4][6] = {
+        { 1, 1, 1, 1, 1, 0 },
+        { 0, 1, -1, 2, -2, 0 },
+        { 0, 1, 1, 4, 4, 0 },
+        { 0, 1, -1, 8, -8, 1 },
+    };
+};
+
+template<>
+struct winograd_matrices<2, 5>
+{
+    static constexpr float bt[6][6] = {
+        { 4, 0, -5, 0, 1, 0 },  { 0, -4, -4, 1, 1, 0 }, { 0, 4, -4, -1, 1, 0 },
+        { 0, -2, -1, 2, 1, 0 }, { 0, 2, -1, -2, 1, 0 }, { 0, 4, 0, -5, 0, 1 },
+    };
+
+    static constexpr double g[6][5] = {
+        { 1.0 / 4, 0, 0, 0, 0 },
+        { -1.0 / 6, -1.0 / 6, -1.0 / 6, -1.0 / 6, -1.0 / 6 },
+        { -1.0 / 6, 1.0 / 6, -1.0 / 6, 1.0 / 6, -1.0 / 6 },
+        { 1.0 / 24, 1.0 / 12, 1.0 / 6, 1.0 / 3, 2.0 / 3 },
+        { 1.0 / 24, -1.0 / 12, 1.0 / 6, -1.0 / 3, 2.0 / 3 },
+        { 0, 0, 0, 0, 1 },
+    };
+
+    static constexpr float at[2][6] = {
+        { 1, 1, 1, 1, 1, 0 },
+        { 0, 1, -1, 2, -2, 1 },
+    };
+};
+
+/// out = c * in for a constant matrix c. the loops are unrolled, so the terms with a zero in c
+/// are dropped at compile time and those with 1 or -1 become additions.
+template<int n, int k, int p, typename vector_t>
+inline void
+left_multiply(float const (&c)[n][k], vector_t const (&in)[k][p], vector_t (&out)[n][p])
+{
+#pragma GCC unroll 8
+    for (int i = 0; i < n; i++) {
+#pragma GCC unroll 8
+        for (int j = 0; j < p; j++) {
+            vector_t s = {};
+            bool first = true;
+
+#pragma GCC unroll 8
+            for (int l = 0; l < k; l++) {
+                if (c[i][l] != 0) {
+                    s = first ? c[i][l] * in[l][j] : s + c[i][l] * in[l][j];
+                    first = false;
+                }
+            }
+
+            out[i][j] = s;
+        }
+    }
+}
+
+/// out = in * c^T for a constant matrix c, see left_multiply()
+template<int n, int k, int p, typename vector_t>
+inline void
+right_multiply(vector_t const (&in)[n][k], float const (&c)[p][k], vector_t (&out)[n][p])
+{
+#pragma GCC unroll 8
+    for (int i = 0; i < n; i++) {
+#pragma GCC unroll 8
+        for (int j = 0; j < p; j++) {
+            vector_t s = {};
+            bool first = true;
+
+#pragma GCC unroll 8
+            for (int l = 0; l < k; l++) {
+                if (c[j][l] != 0) {
+                    s = first ? c[j][l] * in[i][l] : s + c[j][l] * in[i][l];
+                    first = false;
+                }
+            }
+
+            out[i][j] = s;
+        }
+    }
+}
+
+/// convolve inp (n1 by n2) with win (r by r) like conv() in conv.hpp, with F(m x m, r x r).
+///
+/// the result is split into m by m tiles, each computed from an a by a block of the input as
+/// at * (u . (bt * d * b)) * a, where u = g * win * g^T is transformed once.
+/// the transforms are done with vectors whose lanes are vw consecutive tiles of a row of tiles,
+/// so they take the same instructions as for a single tile.
+///
+/// a task takes a row of tiles. it first copies the a rows of the input it needs to a strip
+/// with zeros around the input and its columns split by their remainder modulo m. the element b
+/// of the tiles t to t + vw - 1 is then the consecutive elements t + b / m of part b % m.
+template<typename vector_t, int m, int r>
+void
+winograd_conv(const int n1,
+              const int n2,
+              float const* const inp,
+              float const* const win,
+              float* const res)
+{
+    constexpr int vw = sizeof(vector_t) / sizeof(float);
+
+    using vector_unalgn_t = typename vector_of<vw>::unalgn_type;
+    using mat = winograd_matrices<m, r>;
+
+    constexpr int a = m + r - 1;
+    constexpr int h = r / 2;
+
+    // transformed window, in double since it is done once
+    float u[a][a];
+    {
+        double gw[a][r] = {};
+        for (int i = 0; i < a; i++) {
+            for (int j = 0; j < r; j++) {
+                for (int k = 0; k < r; k++) {
+                    gw[i][j] += mat::g[i][k] * win[k * r + j];
+                }
+            }
+        }
+        for (int i = 0; i < a; i++) {
+            for (int j = 0; j < a; j++) {
+                double s = 0;
+                for (int k = 0; k < r; k++) {
+                    s += gw[i][k] * mat::g[j][k];
+                }
+                u[i][j] = static_cast<float>(s);
+            }
+        }
+    }
+
+    const int tiles1 = (n1 + m - 1) / m;
+    const int tiles2 = (n2 + m - 1) / m;
+    const int groups = (tiles2 + vw - 1) / vw; // groups of vw tiles in a row of tiles
+    const int sw = groups * vw + (a - 1) / m;  // length of a part of a row of the strip
+
+    parallel_for(0, tiles1, [&](int ti) {
+        static thread_local std::vector<float> strip;
+        strip.resize(a * m * sw);
+
+        // part b of row x of the strip is at (x * m + b) * sw, its element t is column
+        // t * m + b - h of input row ti * m + x - h
+        for (int x = 0; x < a; x++) {
+            const int i = ti * m + x - h;
+            float* const row = strip.data() + x * m * sw;
+
+            if (i < 0 || i >= n1) {
+                std::fill(row, row + m * sw, 0.0f);
+                continue;
+            }
+
+            float const* const in = inp + i * n2;
+
+            for (int b = 0; b < m; b++) {
+                float* const part = row + b * sw;
+
+                for (int t = 0; t < sw; t++) {
+                    const int j = t * m + b - h;
+                    part[t] = (j >= 0 && j < n2) ? in[j] : 0.0f;
+                }
+            }
+        }
+
+        const int rows = std::min(m, n1 - ti * m);
+
+        for (int gi = 0; gi < groups; gi++) {
+            const int t0 = gi * vw;
+
+            vector_t d[a][a], v[a][a];
+
+#pragma GCC unroll 8
+            for (int x = 0; x < a; x++) {
+#pragma GCC unroll 8
+                for (int y = 0; y < a; y++) {
+                    d[x][y] = *reinterpret_cast<vector_unalgn_t const*>(
+                      &strip[(x * m + y % m) * sw + t0 + y / m]);
+                }
+            }
+
+            left_multiply(mat::bt, d, v);
+            right_multiply(v, mat::bt, d);
+
+#pragma GCC unroll 8
+            for (int x = 0; x < a; x++) {
+#pragma GCC unroll 8
+                for (int y = 0; y < a; y++) {
+                    d[x][y] *= u[x][y];
+                }
+            }
+
+            vector_t p[m][a], y[m][m];
+            left_multiply(mat::at, d, p);
+            right_multiply(p, mat::at, y);
+
+            // lane l of y[i][j] is the result at row ti * m + i and column (t0 + l) * m + j
+            const int cols = std::min(vw * m, n2 - t0 * m);
+
+            for (int i = 0; i < rows; i++) {
+                float* const out = res + (ti * m + i) * n2 + t0 * m;
+
+                if (cols == vw * m) {
+#pragma GCC unroll 16
+                    for (int l = 0; l < vw; l++) {
+#pragma GCC unroll 4
+                        for (int j = 0; j < m; j++) {
+                            out[l * m + j] = y[i][j][l];
+                        }
+                    }
+                } else {
+                    for (int c = 0; c < cols; c++) {
+                        out[c] = y[i][c % m][c / m];
+                    }
+                }
+            }
+        }
+    });
+}
+
+/// whether winograd_conv() has an algorithm for windows of nw by nw
+inline bool
+has_winograd(const int nw)
+{
+    return nw == 3 || nw == 5;
+}
+
+/// winograd_conv() with the algorithm for the window, which has_winograd() accepts
+template<typename vector_t>
+void
+winograd_conv(const int n1,
+              const int n2,
+              const int nw,
+              float const* const inp,
+              float const* const win,
+              float* const res)
+{
+    if (nw == 3) {
+        winograd_conv<vector_t, 4, 3>(n1, n2, inp, win, res);
+    } else {
+        winograd_conv<vector_t, 2, 5>(n1, n2, inp, win, res);
+    }
+}
+
+} // namespace
+
+} // namespace cmpe492
@@ -0,0 +1,232 @@
+/// measures the roofs of the roofline model of this machine: the peak floating point rate of
+/// each instruction set (like fma_throughput.cpp, for every vector width) and the stream triad
+/// memory bandwidth, on one thread and on all the threads of the pool.
+/// given the shape of an mm or conv, also prints its arithmetic intensity and the rate it can
+/// attain, which report.py --roofline compares with the rates the kernels reach.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "cpu.hpp"
+#include "thread_pool.hpp"
+
+namespace cmpe492 {
+
+// roofline_peak.cpp, built once per instruction set with dispatching, once otherwise
+#ifdef CMPE492_ROOFLINE_DISPATCH
+namespace isa_sse {
+double
+fma_loop(const long iters);
+} // namespace isa_sse
+
+namespace isa_avx2 {
+double
+fma_loop(const long iters);
+} // namespace isa_avx2
+
+namespace isa_avx512 {
+double
+fma_loop(const long iters);
+} // namespace isa_avx512
+#else
+double
+fma_loop(const long iters);
+#endif
+
+} // namespace cmpe492
+
+namespace {
+
+/// iterations of fma_loop() per call, about 0.1 ms
+constexpr long fma_iters = 1 << 15;
+
+/// elements of each array of the stream triad, 64 mb, far more than the caches
+constexpr long stream_floats = 1 << 24;
+
+/// tasks per thread of the multi-threaded runs, so that a thread that starts late does not hold
+/// up the others by a whole share of the work
+constexpr int tasks_per_thread = 8;
+
+/// a rate on one thread and on all the threads of the pool
+struct roof
+{
+    double one = 0;
+    double all = 0;
+};
+
+/// FLOP/s of the fma loop of one instruction set, the best of the samples
+roof
+peak_flops(double (*fma_loop)(long), cmpe492::bench_options const& opt)
+{
+    const double flops = fma_loop(fma_iters);
+    const int n_tasks = cmpe492::get_num_threads() * tasks_per_thread;
+
+    const auto one = cmpe492::bench_run([&] { fma_loop(fma_iters); }, opt);
+    const auto all = cmpe492::bench_run(
+      [&] { cmpe492::parallel_for(0, n_tasks, [&](int) { fma_loop(fma_iters); }); }, opt);
+
+    return { flops / one.min, flops * n_tasks / all.min };
+}
+
+/// bytes/s of the stream triad a = b + s * c, the best of the samples. like stream, 12 bytes
+/// per element, without the reads of a that caches which allocate on write add.
+roof
+bandwidth(cmpe492::bench_options const& opt)
+{
+    std::vector<float> a(stream_floats), b(stream_floats, 1.0f), c(stream_floats, 2.0f);
+    const double bytes = 12.0 * stream_floats;
+    const int n_tasks = cmpe492::get_num_threads() * tasks_per_thread;
+
+    auto triad = [&](const long i0, const long i1) {
+        float* const __restrict pa = a.data();
+        float const* const __restrict pb = b.data();
+        float const* const __restrict pc = c.data();
+
+        for (long i = i0; i < i1; i++) {
+            pa[i] = pb[i] + 3.0f * pc[i];
+        }
+    };
+
+    const auto one = cmpe492::bench_run([&] { triad(0, stream_floats); }, opt);
+    const auto all = cmpe492::bench_run(
+      [&] {
+          cmpe492::parallel_for(0, n_tasks, [&](int t) {
+              triad(stream_floats * t / n_tasks, stream_floats * (t + 1) / n_tasks);
+          });
+      },
+      opt);
+
+    return { bytes / one.min, bytes / all.min };
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    // the task and shape, with the minimum floating point operations and memory traffic of
+    // mm/bench.cpp and conv/bench.cpp
+    std::string task;
+    std::vector<long> shape;
+    double flops = 0, bytes = 0;
+
+    if (argc == 5 && std::strcmp(argv[1], "mm") == 0) {
+        task = "mm";
+        const double n1 = std::atoi(argv[2]), n2 = std::atoi(argv[3]), n3 = std::atoi(argv[4]);
+        shape = { long(n1), long(n2), long(n3) };
+        flops = 2.0 * n1 * n2 * n3;
+        bytes = 4.0 * (n1 * n2 + n2 * n3 + n1 * n3);
+    } else if (argc == 5 && std::strcmp(argv[1], "conv") == 0) {
+        task = "conv";
+        const double n1 = std::atoi(argv[2]), n2 = std::atoi(argv[3]), nw = std::atoi(argv[4]);
+        shape = { long(n1), long(n2), long(nw) };
+        flops = 2.0 * n1 * n2 * nw * nw;
+        bytes = 4.0 * (2.0 * n1 * n2 + nw * nw);
+    } else if (argc != 1) {
+        std::cout << "usage: " << argv[0] << " [mm n1 n2 n3 | conv n1 n2 nw]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // the samples of a roof take about a fifth of a second, unless set in the environment
+    auto opt = cmpe492::bench_options::from_env();
+    if (!std::getenv("CMPE492_BENCH_MIN_TIME")) {
+        opt.min_time = 0.2;
+    }
+
+    const int threads = cmpe492::get_num_threads();
+
+    struct kernel
+    {
+        char const* name;
+        double (*fma_loop)(long);
+    };
+
+#ifdef CMPE492_ROOFLINE_DISPATCH
+    const cmpe492::isa selected = cmpe492::select_isa();
+    std::vector<kernel> kernels = { { "sse", cmpe492::isa_sse::fma_loop } };
+    if (selected >= cmpe492::isa::avx2) {
+        kernels.push_back({ "avx2", cmpe492::isa_avx2::fma_loop });
+    }
+    if (selected >= cmpe492::isa::avx512) {
+        kernels.push_back({ "avx512", cmpe492::isa_avx512::fma_loop });
+    }
+#else
+    std::vector<kernel> kernels = { { "default", cmpe492::fma_loop } };
+#endif
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "threads:\t" << threads << "\n";
+
+    auto print = [&](std::string const& name, roof r, char const* unit) {
+        std::cout << name << ":\t" << r.one << " " << unit << " (1 thread)\t" << r.all << " "
+                  << unit << " (" << threads << (threads == 1 ? " thread)" : " threads)")
+                  << std::endl;
+    };
+
+    // the roof is the rate of the widest vectors, which the dispatching kernels use
+    std::vector<roof> peaks;
+    for (auto const& k : kernels) {
+        roof r = peak_flops(k.fma_loop, opt);
+        print(std::string("peak ") + k.name, { r.one * 1e-9, r.all * 1e-9 }, "GFLOP/s");
+        peaks.push_back(r);
+    }
+    const roof peak = peaks.back();
+
+    const roof bw = bandwidth(opt);
+    print("triad bandwidth", { bw.one * 1e-9, bw.all * 1e-9 }, "GB/s");
+
+    const roof ridge = { peak.one / bw.one, peak.all / bw.all };
+    print("ridge point", ridge, "FLOP/byte");
+
+    roof attainable;
+    if (!task.empty()) {
+        const double intensity = flops / bytes;
+        attainable = { std::min(peak.one, intensity * bw.one),
+                       std::min(peak.all, intensity * bw.all) };
+
+        std::cout << task;
+        for (long n : shape) {
+            std::cout << " " << n;
+        }
+        std::cout << "\n";
+        std::cout << "intensity:\t" << intensity << " FLOP/byte, "
+                  << (intensity < ridge.all ? "memory" : "compute") << " bound\n";
+        print("attainable", { attainable.one * 1e-9, attainable.all * 1e-9 }, "GFLOP/s");
+    }
+
+    // rates in GFLOP/s and GB/s, the pairs are for 1 thread and all the threads
+    auto pair = [](roof r, double scale) {
+        std::ostringstream out;
+        out << std::setprecision(9) << "[" << r.one * scale << ", " << r.all * scale << "]";
+        return out.str();
+    };
+
+    std::cout << std::setprecision(9) << std::defaultfloat;
+    std::cout << "json:\t{\"threads\": " << threads << ", \"peaks\": {";
+    for (size_t i = 0; i < kernels.size(); i++) {
+        std::cout << (i ? ", " : "") << "\"" << kernels[i].name
+                  << "\": " << pair(peaks[i], 1e-9);
+    }
+    std::cout << "}, \"gflops\": " << pair(peak, 1e-9) << ", \"gbytes\": " << pair(bw, 1e-9)
+              << ", \"ridge\": " << pair(ridge, 1);
+    if (!task.empty()) {
+        std::cout << ", \"task\": \"" << task << "\", \"shape\": [";
+        for (size_t i = 0; i < shape.size(); i++) {
+            std::cout << (i ? ", " : "") << shape[i];
+        }
+        std::cout << "], \"intensity\": " << flops / bytes
+                  << ", \"attainable\": " << pair(attainable, 1e-9);
+    }
+    std::cout << "}\n";
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
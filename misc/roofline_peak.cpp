@@ -0,0 +1,71 @@
+#include "simd.hpp"
+
+// the peak floating point rate of the vectors of one instruction set. like the kernels, this
+// file is built once per instruction set by the roofline tool, each copy in its own namespace
+// named by CMPE492_NAMESPACE.
+#ifndef CMPE492_VECTOR_WIDTH
+#define CMPE492_VECTOR_WIDTH 8
+#endif
+
+CMPE492_TARGET_BEGIN
+
+namespace cmpe492 {
+
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
+namespace {
+
+using vector_t = vector_of<CMPE492_VECTOR_WIDTH>::type;
+constexpr int vw = sizeof(vector_t) / sizeof(float); // vector width
+
+/// independent chains of multiply-adds, more than the latency times the throughput of the fma
+/// units of current cpus (4 cycles, 2 a cycle), so that they are never waiting
+constexpr int n_chains = 10;
+
+/// keeps the results, so that the loop is not optimized away
+volatile float sink;
+
+} // namespace
+
+/// iters iterations of a multiply-add of every chain, which compile to fma instructions when the
+/// instruction set has them. returns the floating point operations done.
+double
+fma_loop(const long iters)
+{
+    // the chains converge to a / (1 - m) = 1, they neither overflow nor become denormal. none may
+    // start there, the compiler would see that it stays there and drop it.
+    vector_t acc[n_chains];
+    for (int k = 0; k < n_chains; k++) {
+        acc[k] = vector_t{} + float(k + 2);
+    }
+
+    const vector_t m = vector_t{} + 0.999f;
+    const vector_t a = vector_t{} + 0.001f;
+
+    for (long i = 0; i < iters; i++) {
+#pragma GCC unroll 10
+        for (int k = 0; k < n_chains; k++) {
+            acc[k] = acc[k] * m + a;
+        }
+    }
+
+    float sum = 0;
+    for (int k = 0; k < n_chains; k++) {
+        for (int v = 0; v < vw; v++) {
+            sum += acc[k][v];
+        }
+    }
+    sink = sum;
+
+    return 2.0 * n_chains * vw * iters;
+}
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
+} // namespace cmpe492
+
+CMPE492_TARGET_END
@@ -1,9 +1,9 @@
 #include <cstdlib>
 #include <iostream>
 
+#include "bench.hpp"
 #include "generator.hpp"
 #include "mm.hpp"
-#include "timer.hpp"
 
 int
 main(int argc, char* argv[])
@@ -32,11 +32,22 @@ main(int argc, char* argv[])
     cmpe492::random_fill(mat1.begin(), mat1.end());
     cmpe492::random_fill(mat2.begin(), mat2.end());
 
-    std::cout << "running time:\t" << std::flush;
-    {
-        cmpe492::timer t{ std::cout };
-        cmpe492::mm(n1, n2, n3, mat1.data(), mat2.data(), res.data());
-    }
+    // opened before the first call, which starts the thread pool, so that its workers are counted
+    cmpe492::perf_counters counters;
+
+    const auto st = cmpe492::bench_run(
+      [&] { cmpe492::mm(n1, n2, n3, mat1.data(), mat2.data(), res.data()); },
+      cmpe492::bench_options::from_env(),
+      &counters);
+
+    // each matrix is read or written once at least
+    cmpe492::bench_report(std::cout,
+                          "mm",
+                          { n1, n2, n3 },
+                          st,
+                          2.0 * n1 * n2 * n3,
+                          4.0 * (double(n1) * n2 + double(n2) * n3 + double(n1) * n3),
+                          &counters);
 
     std::cout << "========" << std::endl;
 
@@ -0,0 +1,61 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "bench.hpp"
+#include "generator.hpp"
+#include "mm.hpp"
+
+int
+main(int argc, char* argv[])
+{
+    int count;
+
+    if (argc == 1) {
+        count = 10000;
+    } else if (argc == 2) {
+        count = std::atoi(argv[1]);
+    } else {
+        std::cout << "usage: " << argv[0] << " [count]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // items per second at the median of the samples
+    std::cout << "size\tmm loop\t\tbatched\t\tshared mat2\t(items/s)" << std::endl;
+
+    for (int n : { 8, 16, 32, 64 }) {
+        const int sz = n * n;
+
+        std::vector<float> mat1(count * sz);
+        std::vector<float> mat2(count * sz);
+        std::vector<float> res(count * sz);
+
+        cmpe492::random_fill(mat1.begin(), mat1.end());
+        cmpe492::random_fill(mat2.begin(), mat2.end());
+
+        const auto st = cmpe492::bench_run_interleaved({
+          [&] {
+              for (int b = 0; b < count; b++) {
+                  cmpe492::mm(n, n, n, &mat1[b * sz], &mat2[b * sz], &res[b * sz]);
+              }
+          },
+          [&] {
+              cmpe492::mm_batched(count, n, n, n, mat1.data(), sz, mat2.data(), sz, res.data(), sz);
+          },
+          [&] {
+              cmpe492::mm_batched(count, n, n, n, mat1.data(), sz, mat2.data(), 0, res.data(), sz);
+          },
+        });
+
+        std::cout << n << std::scientific << std::setprecision(3);
+        for (auto const& s : st) {
+            std::cout << "\t" << count / s.median;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <array>
+#include <vector>
+
+#include "bench_driver.hpp"
+#include "generator.hpp"
+#include "mm.hpp"
+
+// bench-mm, the variants of mm() registered with util/registry.hpp run in turn on the same
+// matrices. each result is compared with the one of the first variant.
+
+namespace {
+
+struct mm_task
+{
+    using fn = cmpe492::mm_fn;
+    using shape_t = std::array<int, 3>;
+
+    static constexpr char const* name = "mm";
+    static constexpr char const* shape_names = "n1 n2 n3";
+    static constexpr shape_t default_shape = { 1500, 1500, 1500 };
+
+    static double flops(shape_t s) { return 2.0 * s[0] * s[1] * s[2]; }
+
+    // each matrix is read or written once at least
+    static double bytes(shape_t s)
+    {
+        return 4.0 * (double(s[0]) * s[1] + double(s[1]) * s[2] + double(s[0]) * s[2]);
+    }
+
+    struct operands
+    {
+        int n1, n2, n3;
+        std::vector<float> mat1, mat2, res;
+
+        explicit operands(shape_t s)
+          : n1(s[0])
+          , n2(s[1])
+          , n3(s[2])
+          , mat1(n1 * n2)
+          , mat2(n2 * n3)
+          , res(n1 * n3)
+        {
+            cmpe492::random_fill(mat1.begin(), mat1.end());
+            cmpe492::random_fill(mat2.begin(), mat2.end());
+        }
+
+        void call(fn* kernel) { kernel(n1, n2, n3, mat1.data(), mat2.data(), res.data()); }
+    };
+};
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    return cmpe492::bench_driver<mm_task>(argc, argv);
+}
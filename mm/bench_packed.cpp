@@ -0,0 +1,54 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "bench.hpp"
+#include "generator.hpp"
+#include "mm.hpp"
+
+/// multiply a weight matrix, packed once, with a batch, compared with mm() on the unpacked one
+int
+main(int argc, char* argv[])
+{
+    int n1, n2, n3;
+
+    if (argc == 1) {
+        n1 = 64;
+        n2 = 1024;
+        n3 = 1024;
+    } else if (argc == 4) {
+        n1 = std::atoi(argv[1]);
+        n2 = std::atoi(argv[2]);
+        n3 = std::atoi(argv[3]);
+    } else {
+        std::cout << "usage: " << argv[0] << " [n1 n2 n3]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << n1 << " " << n2 << " " << n3 << std::endl;
+
+    std::vector<float> mat1(n1 * n2);
+    std::vector<float> mat2(n2 * n3);
+    std::vector<float> res(n1 * n3);
+
+    cmpe492::random_fill(mat1.begin(), mat1.end());
+    cmpe492::random_fill(mat2.begin(), mat2.end());
+
+    cmpe492::packed_matrix mat2_packed = cmpe492::pack_rhs(n2, n3, mat2.data());
+
+    const auto st = cmpe492::bench_run_interleaved(
+      { [&] { cmpe492::mm(n1, n2, n3, mat1.data(), mat2.data(), res.data()); },
+        [&] { cmpe492::mm(n1, mat1.data(), mat2_packed, res.data()); } });
+
+    // each matrix is read or written once at least
+    cmpe492::bench_report_baseline(std::cout, "unpacked", st[0], st[1]);
+    cmpe492::bench_report(std::cout,
+                          "mm_packed",
+                          { n1, n2, n3 },
+                          st[1],
+                          2.0 * n1 * n2 * n3,
+                          4.0 * (double(n1) * n2 + double(n2) * n3 + double(n1) * n3));
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
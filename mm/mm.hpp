@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdlib>
+#include <memory>
+
 namespace cmpe492 {
 
 /// multiply matrices mat1 and mat2 and put the result in res
@@ -7,4 +10,127 @@ namespace cmpe492 {
 void
 mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res);
 
-} // namespace cmpe492
\ No newline at end of file
+/// the type of mm(), which the variants built for bench-mm register (see util/registry.hpp)
+using mm_fn = void(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res);
+
+/// whether an operand of sgemm() is used as it is stored or transposed
+enum class transpose
+{
+    no,
+    yes
+};
+
+/// general matrix multiplication like cblas_sgemm with row-major storage:
+/// res = alpha * op(mat1) * op(mat2) + beta * res
+/// where op(mat1) is n1 by n2, op(mat2) is n2 by n3, and res is n1 by n3.
+/// op(x) is x, or its transpose if the corresponding trans argument is transpose::yes.
+/// ld1, ld2 and ld_res are the distances between the consecutive rows of the matrices as stored.
+/// res is not read if beta is 0.
+/// only the mm_simd2, mm_simd2_mt, mm_dispatch and mm_blas builds provide it.
+void
+sgemm(transpose trans1,
+      transpose trans2,
+      int n1,
+      int n2,
+      int n3,
+      float alpha,
+      float const* mat1,
+      int ld1,
+      float const* mat2,
+      int ld2,
+      float beta,
+      float* res,
+      int ld_res);
+
+/// an operand of mm() packed into the internal layout of the kernel, so that it can be reused
+/// across calls without being packed again. create it with pack_lhs() or pack_rhs().
+/// the layout is specific to the implementation, only the packed versions of mm() understand it.
+class packed_matrix
+{
+    struct deleter
+    {
+        void operator()(void* p) const { std::free(p); }
+    };
+
+    int rows_ = 0;
+    int cols_ = 0;
+    bool lhs_ = false;
+    std::unique_ptr<void, deleter> data_;
+
+public:
+    packed_matrix() = default;
+
+    /// takes the ownership of data, which must be allocated with std::malloc or std::aligned_alloc
+    packed_matrix(int rows, int cols, bool lhs, void* data)
+      : rows_(rows)
+      , cols_(cols)
+      , lhs_(lhs)
+      , data_(data)
+    {}
+
+    /// dimensions of the original matrix
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+
+    /// whether this is the left (mat1) or the right (mat2) operand of mm()
+    bool is_lhs() const { return lhs_; }
+
+    void const* data() const { return data_.get(); }
+};
+
+/// pack mat1, which is n1 by n2, as the left operand of mm()
+/// only the mm_simd2, mm_simd2_mt and mm_dispatch builds provide it.
+packed_matrix
+pack_lhs(int n1, int n2, float const* mat1);
+
+/// pack mat2, which is n2 by n3, as the right operand of mm()
+/// only the mm_simd2, mm_simd2_mt and mm_dispatch builds provide it.
+packed_matrix
+pack_rhs(int n2, int n3, float const* mat2);
+
+/// multiply prepacked matrices mat1 and mat2 and put the result in res
+/// only the mm_simd2, mm_simd2_mt and mm_dispatch builds provide it.
+void
+mm(packed_matrix const& mat1, packed_matrix const& mat2, float* res);
+
+/// multiply mat1, which is n1 by mat2.rows(), with the prepacked matrix mat2
+/// and put the result in res
+/// only the mm_simd2, mm_simd2_mt and mm_dispatch builds provide it.
+void
+mm(int n1, float const* mat1, packed_matrix const& mat2, float* res);
+
+/// multiply count independent pairs of matrices, res[b] = mat1[b] * mat2[b] for each b.
+/// mat1[b] is n1[b] by n2[b], mat2[b] is n2[b] by n3[b] and res[b] is n1[b] by n3[b].
+/// only the mm_simd2, mm_simd2_mt and mm_dispatch builds provide it.
+void
+mm_batched(int count,
+           int const* n1,
+           int const* n2,
+           int const* n3,
+           float const* const* mat1,
+           float const* const* mat2,
+           float* const* res);
+
+/// multiply count independent pairs of matrices of the same shape.
+/// item b is mat1 + b * stride1 (n1 by n2) times mat2 + b * stride2 (n2 by n3), and is written to
+/// res + b * stride_res (n1 by n3). stride2 can be 0 to multiply all items with the same mat2.
+/// only the mm_simd2, mm_simd2_mt and mm_dispatch builds provide it.
+void
+mm_batched(int count,
+           int n1,
+           int n2,
+           int n3,
+           float const* mat1,
+           int stride1,
+           float const* mat2,
+           int stride2,
+           float* res,
+           int stride_res);
+
+/// name of the instruction set ("sse", "avx2" or "avx512") of the kernel that is used.
+/// only the dispatching build (mm_dispatch) provides it, the kernel is chosen once on the first
+/// call according to the cpu and the CMPE492_ISA environment variable.
+char const*
+mm_isa();
+
+} // namespace cmpe492
@@ -0,0 +1,36 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+#include "mm.hpp"
+#include "registry.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+// built whole with -mavx512f for test-mm_avx512, only the kernel targets it in bench-mm
+CMPE492_TARGET_BEGIN
+
+#include "mm_kernel.hpp"
+
+namespace cmpe492 {
+
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
+/// 16-wide vectors, the 14x32 micro-tile takes 28 of the 32 zmm registers
+void
+mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
+{
+    mm_kernel<16, 14, 2>::mm(n1, n2, n3, mat1, mat2, res);
+}
+
+CMPE492_TARGET_END
+
+CMPE492_REGISTER_KERNEL(mm_fn, mm);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
+} // namespace cmpe492
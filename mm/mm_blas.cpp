@@ -1,9 +1,14 @@
 #include "mm.hpp"
+#include "registry.hpp"
 
 #include <cblas.h>
 
 namespace cmpe492 {
 
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
 void
 mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
 {
@@ -11,4 +16,41 @@ mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
       CblasRowMajor, CblasNoTrans, CblasNoTrans, n1, n3, n2, 1.0, mat1, n2, mat2, n3, 1.0, res, n3);
 }
 
+void
+sgemm(transpose trans1,
+      transpose trans2,
+      int n1,
+      int n2,
+      int n3,
+      float alpha,
+      float const* mat1,
+      int ld1,
+      float const* mat2,
+      int ld2,
+      float beta,
+      float* res,
+      int ld_res)
+{
+    cblas_sgemm(CblasRowMajor,
+                trans1 == transpose::yes ? CblasTrans : CblasNoTrans,
+                trans2 == transpose::yes ? CblasTrans : CblasNoTrans,
+                n1,
+                n3,
+                n2,
+                alpha,
+                mat1,
+                ld1,
+                mat2,
+                ld2,
+                beta,
+                res,
+                ld_res);
+}
+
+CMPE492_REGISTER_KERNEL(mm_fn, mm);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
 } // namespace cmpe492
\ No newline at end of file
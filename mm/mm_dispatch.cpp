@@ -0,0 +1,199 @@
+#include "cpu.hpp"
+#include "mm.hpp"
+#include "mm_tuning.hpp"
+#include "registry.hpp"
+
+// mm_simd2_mt.cpp is built once per instruction set, with a matching vector width, into the
+// namespaces below. the functions here, those of mm.hpp and mm_tuning.hpp, forward each call to
+// the copy chosen on the first call.
+// the packed matrices are in the layout of the chosen copy, which does not change afterwards.
+
+#define CMPE492_DECLARE_MM                                                                         \
+    void mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res);            \
+    void sgemm(transpose trans1,                                                                   \
+               transpose trans2,                                                                   \
+               int n1,                                                                             \
+               int n2,                                                                             \
+               int n3,                                                                             \
+               float alpha,                                                                        \
+               float const* mat1,                                                                  \
+               int ld1,                                                                            \
+               float const* mat2,                                                                  \
+               int ld2,                                                                            \
+               float beta,                                                                         \
+               float* res,                                                                         \
+               int ld_res);                                                                        \
+    packed_matrix pack_lhs(int n1, int n2, float const* mat1);                                     \
+    packed_matrix pack_rhs(int n2, int n3, float const* mat2);                                     \
+    void mm(packed_matrix const& mat1, packed_matrix const& mat2, float* res);                     \
+    void mm(int n1, float const* mat1, packed_matrix const& mat2, float* res);                     \
+    void mm_batched(int count,                                                                     \
+                    int const* n1,                                                                 \
+                    int const* n2,                                                                 \
+                    int const* n3,                                                                 \
+                    float const* const* mat1,                                                      \
+                    float const* const* mat2,                                                      \
+                    float* const* res);                                                            \
+    void mm_batched(int count,                                                                     \
+                    int n1,                                                                        \
+                    int n2,                                                                        \
+                    int n3,                                                                        \
+                    float const* mat1,                                                             \
+                    int stride1,                                                                   \
+                    float const* mat2,                                                             \
+                    int stride2,                                                                   \
+                    float* res,                                                                    \
+                    int stride_res);                                                               \
+    mm_config mm_get_config(int n1, int n2, int n3);                                               \
+    void mm_force_config(mm_config const* cfg);                                                    \
+    char const* mm_tuning_name();
+
+namespace cmpe492 {
+
+namespace isa_sse {
+CMPE492_DECLARE_MM
+} // namespace isa_sse
+
+namespace isa_avx2 {
+CMPE492_DECLARE_MM
+} // namespace isa_avx2
+
+namespace isa_avx512 {
+CMPE492_DECLARE_MM
+} // namespace isa_avx512
+
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
+namespace {
+
+isa
+selected()
+{
+    static const isa selected_isa = select_isa();
+    return selected_isa;
+}
+
+} // namespace
+
+// call the function with the given arguments from the namespace of the selected instruction set
+#define CMPE492_DISPATCH(call)                                                                     \
+    switch (selected()) {                                                                          \
+        case isa::avx512:                                                                          \
+            return isa_avx512::call;                                                               \
+        case isa::avx2:                                                                            \
+            return isa_avx2::call;                                                                 \
+        default:                                                                                   \
+            return isa_sse::call;                                                                  \
+    }
+
+char const*
+mm_isa()
+{
+    return isa_name(selected());
+}
+
+void
+mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
+{
+    CMPE492_DISPATCH(mm(n1, n2, n3, mat1, mat2, res));
+}
+
+void
+sgemm(transpose trans1,
+      transpose trans2,
+      int n1,
+      int n2,
+      int n3,
+      float alpha,
+      float const* mat1,
+      int ld1,
+      float const* mat2,
+      int ld2,
+      float beta,
+      float* res,
+      int ld_res)
+{
+    CMPE492_DISPATCH(
+      sgemm(trans1, trans2, n1, n2, n3, alpha, mat1, ld1, mat2, ld2, beta, res, ld_res));
+}
+
+packed_matrix
+pack_lhs(int n1, int n2, float const* mat1)
+{
+    CMPE492_DISPATCH(pack_lhs(n1, n2, mat1));
+}
+
+packed_matrix
+pack_rhs(int n2, int n3, float const* mat2)
+{
+    CMPE492_DISPATCH(pack_rhs(n2, n3, mat2));
+}
+
+void
+mm(packed_matrix const& mat1, packed_matrix const& mat2, float* res)
+{
+    CMPE492_DISPATCH(mm(mat1, mat2, res));
+}
+
+void
+mm(int n1, float const* mat1, packed_matrix const& mat2, float* res)
+{
+    CMPE492_DISPATCH(mm(n1, mat1, mat2, res));
+}
+
+void
+mm_batched(int count,
+           int const* n1,
+           int const* n2,
+           int const* n3,
+           float const* const* mat1,
+           float const* const* mat2,
+           float* const* res)
+{
+    CMPE492_DISPATCH(mm_batched(count, n1, n2, n3, mat1, mat2, res));
+}
+
+void
+mm_batched(int count,
+           int n1,
+           int n2,
+           int n3,
+           float const* mat1,
+           int stride1,
+           float const* mat2,
+           int stride2,
+           float* res,
+           int stride_res)
+{
+    CMPE492_DISPATCH(
+      mm_batched(count, n1, n2, n3, mat1, stride1, mat2, stride2, res, stride_res));
+}
+
+mm_config
+mm_get_config(int n1, int n2, int n3)
+{
+    CMPE492_DISPATCH(mm_get_config(n1, n2, n3));
+}
+
+/// forces the configuration of the chosen copy only, the one that the calls go to
+void
+mm_force_config(mm_config const* cfg)
+{
+    CMPE492_DISPATCH(mm_force_config(cfg));
+}
+
+char const*
+mm_tuning_name()
+{
+    CMPE492_DISPATCH(mm_tuning_name());
+}
+
+CMPE492_REGISTER_KERNEL(mm_fn, mm);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
+} // namespace cmpe492
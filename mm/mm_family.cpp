@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+#include "mm.hpp"
+#include "registry.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+// one configuration of the mm_kernel family, chosen with compile definitions.
+// add_mm_kernel() in CMakeLists.txt builds the test and bench for a configuration.
+#if !defined(CMPE492_MM_WIDTH) || !defined(CMPE492_MM_MR) || !defined(CMPE492_MM_NB)
+#error "CMPE492_MM_WIDTH, CMPE492_MM_MR and CMPE492_MM_NB must be defined"
+#endif
+
+#ifndef CMPE492_MM_UNROLL
+#define CMPE492_MM_UNROLL 1
+#endif
+
+// the kernel is compiled for the instruction set of its vector width, see util/simd.hpp
+CMPE492_TARGET_BEGIN
+
+#include "mm_kernel.hpp"
+
+namespace cmpe492 {
+
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
+void
+mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
+{
+    mm_kernel<CMPE492_MM_WIDTH, CMPE492_MM_MR, CMPE492_MM_NB, CMPE492_MM_UNROLL>::mm(
+      n1, n2, n3, mat1, mat2, res);
+}
+
+CMPE492_TARGET_END
+
+CMPE492_REGISTER_KERNEL(mm_fn, mm);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
+} // namespace cmpe492
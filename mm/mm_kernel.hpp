@@ -0,0 +1,282 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+namespace cmpe492 {
+
+namespace {
+
+/// a family of register-blocked mm kernels, generated at compile time.
+///
+/// the micro-kernel keeps an mr x (nb * width) tile of the result in mr * nb vector registers and
+/// updates it with broadcast fmas, an element of mat1 times a row of nb vectors of mat2.
+/// the depth loop is unrolled unroll times.
+/// a configuration fits in the registers if mr * nb + nb + 1 is at most 16 (sse, avx2) or 32
+/// (avx-512), and needs to be compiled with the instruction set of its vector width.
+///
+/// the operands are packed into micro-panels of mr rows of mat1 and nr columns of mat2, split into
+/// depth blocks of kc. the result is split into tiles of mc x nc micro-panels, scheduled on the
+/// thread pool.
+template<int width, int mr, int nb, int unroll = 1>
+struct mm_kernel
+{
+    using vector_t = typename vector_of<width>::type;
+    using vector_unalgn_t = typename vector_of<width>::unalgn_type;
+
+    static constexpr int nr = nb * width; // columns of the micro-tile
+
+    /// cache blocking parameters, in micro-panels of mr rows and nr columns
+    static constexpr int kc = 512;                    // depth of a block
+    static constexpr int mc = std::max(1, 320 / mr);  // an (mc * mr) x kc block of mat1 is 640 KiB
+    static constexpr int nc = std::max(1, 3072 / nr); // a kc x (nc * nr) panel of mat2 is 6 MiB
+
+    static_assert(mr > 0 && nb > 0 && unroll > 0);
+
+    /// offset, in floats, of micro-panel i (of w rows or columns) in the depth block starting at
+    /// pc. inside a depth block, the micro-panels of all n_blk row or column blocks are contiguous.
+    static int panel_offset(const int pc, const int i, const int n2, const int n_blk, const int w)
+    {
+        const int len = std::min(kc, n2 - pc);
+        return (pc * n_blk + i * len) * w;
+    }
+
+    /// pack rows [i * mr, (i + 1) * mr) of mat1 (n1 by n2) so that the mr elements of a column
+    /// are consecutive. out-of-range rows are 0.
+    static void pack_mat1(const int i,
+                          const int n1,
+                          const int n2,
+                          const int n1r,
+                          float const* mat1,
+                          float* wrap)
+    {
+        for (int pc = 0; pc < n2; pc += kc) {
+            const int len = std::min(kc, n2 - pc);
+            float* const panel = wrap + panel_offset(pc, i, n2, n1r, mr);
+
+            for (int k = 0; k < len; k++) {
+                for (int r = 0; r < mr; r++) {
+                    const int row = i * mr + r;
+
+                    panel[k * mr + r] = (row < n1) ? mat1[row * n2 + pc + k] : 0.0f;
+                }
+            }
+        }
+    }
+
+    /// pack columns [j * nr, (j + 1) * nr) of mat2 (n2 by n3) so that each row of the
+    /// micro-panel is nb consecutive vectors. out-of-range columns are 0.
+    static void pack_mat2(const int j,
+                          const int n2,
+                          const int n3,
+                          const int n3r,
+                          float const* mat2,
+                          float* wrap)
+    {
+        for (int pc = 0; pc < n2; pc += kc) {
+            const int len = std::min(kc, n2 - pc);
+            float* const panel = wrap + panel_offset(pc, j, n2, n3r, nr);
+
+            for (int k = 0; k < len; k++) {
+                for (int c = 0; c < nr; c++) {
+                    const int col = j * nr + c;
+
+                    panel[k * nr + c] = (col < n3) ? mat2[(pc + k) * n3 + col] : 0.0f;
+                }
+            }
+        }
+    }
+
+    /// one step of the micro-kernel, the rank-1 update of t with column k of the micro-panels
+    static inline void step(vector_t (&t)[mr][nb],
+                            const int k,
+                            float const* __restrict a,
+                            vector_t const* __restrict b)
+    {
+        vector_t bk[nb];
+
+#pragma GCC unroll 8
+        for (int q = 0; q < nb; q++) {
+            bk[q] = b[k * nb + q];
+        }
+
+#pragma GCC unroll 32
+        for (int r = 0; r < mr; r++) {
+#pragma GCC unroll 8
+            for (int q = 0; q < nb; q++) {
+                // a scalar times a vector is a broadcast fma
+                t[r][q] += a[k * mr + r] * bk[q];
+            }
+        }
+    }
+
+    /// store the micro-tile t at row i and column j of res, or add it to res if accumulate is set
+    static void writeback(vector_t const (&t)[mr][nb],
+                          const int i,
+                          const int j,
+                          const int n1,
+                          const int n3,
+                          const bool accumulate,
+                          float* res)
+    {
+        const int ri0 = i * mr;
+        const int rj0 = j * nr;
+
+        if (ri0 + mr <= n1 && rj0 + nr <= n3) {
+            for (int r = 0; r < mr; r++) {
+                for (int q = 0; q < nb; q++) {
+                    vector_unalgn_t* const out =
+                      reinterpret_cast<vector_unalgn_t*>(&res[(ri0 + r) * n3 + rj0 + q * width]);
+
+                    *out = accumulate ? *out + t[r][q] : t[r][q];
+                }
+            }
+            return;
+        }
+
+        // partial tile at the bottom or right edge of res
+        for (int r = 0; r < mr && ri0 + r < n1; r++) {
+            for (int c = 0; c < nr && rj0 + c < n3; c++) {
+                float& out = res[(ri0 + r) * n3 + rj0 + c];
+                const float v = t[r][c / width][c % width];
+
+                out = accumulate ? out + v : v;
+            }
+        }
+    }
+
+    /// multiply a micro-panel of mat1 with a micro-panel of mat2, both of depth len, and write
+    /// the result to the micro-tile at row i and column j of res
+    static void micro_kernel(const int i,
+                             const int j,
+                             const int len,
+                             const int n1,
+                             const int n3,
+                             float const* __restrict a,
+                             vector_t const* __restrict b,
+                             const bool accumulate,
+                             float* res)
+    {
+        vector_t t[mr][nb] = {};
+
+        int k = 0;
+        for (; k + unroll <= len; k += unroll) {
+#pragma GCC unroll 16
+            for (int u = 0; u < unroll; u++) {
+                step(t, k + u, a, b);
+            }
+        }
+        for (; k < len; k++) {
+            step(t, k, a, b);
+        }
+
+        writeback(t, i, j, n1, n3, accumulate, res);
+    }
+
+    /// a unit of work for the scheduler: row micro-panels [i0, i1) and column micro-panels
+    /// [j0, j1) of the result
+    struct tile
+    {
+        int i0, i1;
+        int j0, j1;
+    };
+
+    /// job for each worker thread, computes the tile tl of res
+    static void mm_helper(tile const& tl,
+                          const int n1,
+                          const int n2,
+                          const int n3,
+                          const int n1r,
+                          const int n3r,
+                          float const* mat1_wrap,
+                          float const* mat2_wrap,
+                          float* res)
+    {
+        for (int pc = 0; pc < n2; pc += kc) {
+            const int len = std::min(kc, n2 - pc);
+
+            for (int j = tl.j0; j < tl.j1; j++) {
+                vector_t const* const b = reinterpret_cast<vector_t const*>(
+                  mat2_wrap + panel_offset(pc, j, n2, n3r, nr));
+
+                for (int i = tl.i0; i < tl.i1; i++) {
+                    float const* const a = mat1_wrap + panel_offset(pc, i, n2, n1r, mr);
+
+                    micro_kernel(i, j, len, n1, n3, a, b, pc > 0, res);
+                }
+            }
+        }
+    }
+
+    /// multiply matrices mat1 and mat2 and put the result in res, see mm() in mm.hpp
+    static void mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
+    {
+        if (n2 == 0) {
+            std::fill(res, res + n1 * n3, 0.0f);
+            return;
+        }
+
+        if (n1 == 0 || n3 == 0) {
+            return;
+        }
+
+        const int n1r = (n1 + mr - 1) / mr;
+        const int n3r = (n3 + nr - 1) / nr;
+
+        // the sizes are rounded up to whole vectors for aligned_alloc
+        auto alloc = [](int n_floats) {
+            const int n_vec = (n_floats + width - 1) / width;
+            float* const p =
+              static_cast<float*>(aligned_alloc(sizeof(vector_t), n_vec * sizeof(vector_t)));
+            assert(p);
+            return p;
+        };
+
+        float* const mat1_wrap = alloc(n1r * mr * n2);
+        float* const mat2_wrap = alloc(n3r * nr * n2);
+
+        parallel_for(0, n1r, [&](int i) { pack_mat1(i, n1, n2, n1r, mat1, mat1_wrap); });
+        parallel_for(0, n3r, [&](int j) { pack_mat2(j, n2, n3, n3r, mat2, mat2_wrap); });
+
+        // split the result into a 2d grid of tiles, which are shrunk (down to a single
+        // micro-tile) until there are enough of them to balance the load among the threads
+        const int num_thr = get_num_threads();
+
+        int tm = std::min(mc, n1r);
+        int tn = std::min(nc, n3r);
+
+        auto num_tiles = [&] { return ((n1r + tm - 1) / tm) * ((n3r + tn - 1) / tn); };
+
+        while (num_tiles() < 4 * num_thr && (tm > 1 || tn > 1)) {
+            if (tn >= tm) {
+                tn = (tn + 1) / 2;
+            } else {
+                tm = (tm + 1) / 2;
+            }
+        }
+
+        const int n_tm = (n1r + tm - 1) / tm;
+
+        // consecutive tasks share the same column tile, so they reuse the same panel of mat2_wrap
+        parallel_for(0, num_tiles(), [&](int t) {
+            tile tl;
+            tl.i0 = t % n_tm * tm;
+            tl.i1 = std::min(tl.i0 + tm, n1r);
+            tl.j0 = t / n_tm * tn;
+            tl.j1 = std::min(tl.j0 + tn, n3r);
+
+            mm_helper(tl, n1, n2, n3, n1r, n3r, mat1_wrap, mat2_wrap, res);
+        });
+
+        free(mat1_wrap);
+        free(mat2_wrap);
+    }
+};
+
+} // namespace
+
+} // namespace cmpe492
@@ -1,7 +1,12 @@
 #include "mm.hpp"
+#include "registry.hpp"
 
 namespace cmpe492 {
 
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
 void
 mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
 {
@@ -28,4 +33,10 @@ mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
     delete[] mat2_trans;
 }
 
+CMPE492_REGISTER_KERNEL(mm_fn, mm);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
 } // namespace cmpe492
\ No newline at end of file
@@ -2,10 +2,15 @@
 #include <cstdlib>
 
 #include "mm.hpp"
+#include "registry.hpp"
 #include "simd.hpp"
 
 namespace cmpe492 {
 
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
 void
 mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
 {
@@ -82,4 +87,10 @@ mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
     free(mat2_trans_align);
 }
 
+CMPE492_REGISTER_KERNEL(mm_fn, mm);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
 } // namespace cmpe492
\ No newline at end of file
@@ -1,28 +1,29 @@
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
-#include <vector>
+#include <memory>
 
 #include "mm.hpp"
+#include "registry.hpp"
 #include "simd.hpp"
 
 namespace cmpe492 {
 
-void
-mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
-{
-    constexpr int nv = 8; // vector size
-    constexpr int nu = 1; // unrolling constant
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
 
-    const int n1r = (n1 + nu * nv - 1) / (nu * nv);
-    const int n3r = (n3 + nu * nv - 1) / (nu * nv);
+namespace {
 
-    float8_t* const mat1_wrap =
-      static_cast<float8_t*>(aligned_alloc(sizeof(float8_t), n1r * n2 * nu * sizeof(float8_t)));
-    float8_t* const mat2_t_wrap =
-      static_cast<float8_t*>(aligned_alloc(sizeof(float8_t), n3r * n2 * nu * sizeof(float8_t)));
+constexpr int nv = 8; // vector size
+constexpr int nu = 1; // unrolling constant
 
-    assert(mat1_wrap);
-    assert(mat2_t_wrap);
+/// pack mat1, n1 by n2 (or n2 by n1 if trans1 is set) with rows ld1 apart,
+/// into mat1_wrap, which has room for n1r * n2 * nu vectors
+void
+pack_mat1(int n1, int n2, float const* mat1, int ld1, bool trans1, float8_t* mat1_wrap)
+{
+    const int n1r = (n1 + nu * nv - 1) / (nu * nv);
 
     for (int i = 0; i < n1r; i++) {
         for (int j = 0; j < n2; j++) {
@@ -30,12 +31,25 @@ mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
                 for (int k2 = 0; k2 < nv; k2++) {
                     int row = (i * nu * nv + k1 * nv + k2);
 
-                    mat1_wrap[(i * n2 * nu) + (j * nu) + (k1)][k2] =
-                      (row < n1) ? mat1[row * n2 + j] : 0.0f;
+                    float v = 0.0f;
+
+                    if (row < n1) {
+                        v = trans1 ? mat1[j * ld1 + row] : mat1[row * ld1 + j];
+                    }
+
+                    mat1_wrap[(i * n2 * nu) + (j * nu) + (k1)][k2] = v;
                 }
             }
         }
     }
+}
+
+/// pack mat2, n2 by n3 (or n3 by n2 if trans2 is set) with rows ld2 apart,
+/// into mat2_t_wrap, which has room for n3r * n2 * nu vectors
+void
+pack_mat2(int n2, int n3, float const* mat2, int ld2, bool trans2, float8_t* mat2_t_wrap)
+{
+    const int n3r = (n3 + nu * nv - 1) / (nu * nv);
 
     for (int i = 0; i < n3r; i++) {
         for (int j = 0; j < n2; j++) {
@@ -43,12 +57,34 @@ mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
                 for (int k2 = 0; k2 < nv; k2++) {
                     int col = (i * nu * nv + k1 * nv + k2);
 
-                    mat2_t_wrap[(i * n2 * nu) + (j * nu) + (k1)][k2] =
-                      (col < n3) ? mat2[j * n3 + col] : 0.0f;
+                    float v = 0.0f;
+
+                    if (col < n3) {
+                        v = trans2 ? mat2[col * ld2 + j] : mat2[j * ld2 + col];
+                    }
+
+                    mat2_t_wrap[(i * n2 * nu) + (j * nu) + (k1)][k2] = v;
                 }
             }
         }
     }
+}
+
+/// res = alpha * mat1 * mat2 + beta * res for the packed matrices.
+/// the rows of res are ld_res apart, res is not read if beta is 0.
+void
+mm_packed(int n1,
+          int n2,
+          int n3,
+          const float alpha,
+          float8_t const* const mat1_wrap,
+          float8_t const* const mat2_t_wrap,
+          const float beta,
+          float* res,
+          const int ld_res)
+{
+    const int n1r = (n1 + nu * nv - 1) / (nu * nv);
+    const int n3r = (n3 + nu * nv - 1) / (nu * nv);
 
     for (int i = 0; i < n1r; i++) {
         for (int j = 0; j < n3r; j++) {
@@ -92,7 +128,10 @@ mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
                             int rj = j * (nu * nv) + q2 * nv + w2 ^ (w1 & 1);
 
                             if (ri < n1 && rj < n3) {
-                                res[ri * n3 + rj] = t[q1][q2][w1][w2];
+                                float& r = res[ri * ld_res + rj];
+                                float v = alpha * t[q1][q2][w1][w2];
+
+                                r = (beta == 0.0f) ? v : beta * r + v;
                             }
                         }
                     }
@@ -100,9 +139,225 @@ mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
             }
         }
     }
+}
+
+/// number of vectors in the packed form of a matrix with n rows (or columns) and depth n2
+int
+packed_size(int n, int n2)
+{
+    return (n + nu * nv - 1) / (nu * nv) * n2 * nu;
+}
+
+float8_t*
+alloc_packed(int n, int n2)
+{
+    float8_t* const wrap = static_cast<float8_t*>(
+      aligned_alloc(sizeof(float8_t), packed_size(n, n2) * sizeof(float8_t)));
+
+    assert(wrap);
+
+    return wrap;
+}
+
+/// sgemm() on plain matrices.
+/// the public functions only call functions of this namespace, so that in the builds for bench-mm
+/// they cannot end up calling the ones of mm.hpp.
+void
+gemm(bool trans1,
+     bool trans2,
+     int n1,
+     int n2,
+     int n3,
+     float alpha,
+     float const* mat1,
+     int ld1,
+     float const* mat2,
+     int ld2,
+     float beta,
+     float* res,
+     int ld_res)
+{
+    float8_t* const mat1_wrap = alloc_packed(n1, n2);
+    float8_t* const mat2_t_wrap = alloc_packed(n3, n2);
+
+    // the transposes are handled while packing
+    pack_mat1(n1, n2, mat1, ld1, trans1, mat1_wrap);
+    pack_mat2(n2, n3, mat2, ld2, trans2, mat2_t_wrap);
+
+    mm_packed(n1, n2, n3, alpha, mat1_wrap, mat2_t_wrap, beta, res, ld_res);
 
     free(mat1_wrap);
     free(mat2_t_wrap);
 }
 
-} // namespace cmpe492
\ No newline at end of file
+} // namespace
+
+void
+mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
+{
+    gemm(false, false, n1, n2, n3, 1.0f, mat1, n2, mat2, n3, 0.0f, res, n3);
+}
+
+void
+sgemm(transpose trans1,
+      transpose trans2,
+      int n1,
+      int n2,
+      int n3,
+      float alpha,
+      float const* mat1,
+      int ld1,
+      float const* mat2,
+      int ld2,
+      float beta,
+      float* res,
+      int ld_res)
+{
+    gemm(trans1 == transpose::yes,
+         trans2 == transpose::yes,
+         n1,
+         n2,
+         n3,
+         alpha,
+         mat1,
+         ld1,
+         mat2,
+         ld2,
+         beta,
+         res,
+         ld_res);
+}
+
+packed_matrix
+pack_lhs(int n1, int n2, float const* mat1)
+{
+    float8_t* const mat1_wrap = alloc_packed(n1, n2);
+    pack_mat1(n1, n2, mat1, n2, false, mat1_wrap);
+
+    return packed_matrix(n1, n2, true, mat1_wrap);
+}
+
+packed_matrix
+pack_rhs(int n2, int n3, float const* mat2)
+{
+    float8_t* const mat2_t_wrap = alloc_packed(n3, n2);
+    pack_mat2(n2, n3, mat2, n3, false, mat2_t_wrap);
+
+    return packed_matrix(n2, n3, false, mat2_t_wrap);
+}
+
+void
+mm(packed_matrix const& mat1, packed_matrix const& mat2, float* res)
+{
+    assert(mat1.is_lhs() && !mat2.is_lhs());
+    assert(mat1.cols() == mat2.rows());
+
+    mm_packed(mat1.rows(),
+              mat1.cols(),
+              mat2.cols(),
+              1.0f,
+              static_cast<float8_t const*>(mat1.data()),
+              static_cast<float8_t const*>(mat2.data()),
+              0.0f,
+              res,
+              mat2.cols());
+}
+
+void
+mm(int n1, float const* mat1, packed_matrix const& mat2, float* res)
+{
+    assert(!mat2.is_lhs());
+
+    const int n2 = mat2.rows();
+    const int n3 = mat2.cols();
+
+    // mat1 is packed into a buffer that is kept between the calls
+    static thread_local std::unique_ptr<void, decltype(&free)> workspace(nullptr, &free);
+    static thread_local int workspace_size = 0;
+
+    if (workspace_size < packed_size(n1, n2)) {
+        workspace.reset(alloc_packed(n1, n2));
+        workspace_size = packed_size(n1, n2);
+    }
+
+    float8_t* const mat1_wrap = static_cast<float8_t*>(workspace.get());
+    pack_mat1(n1, n2, mat1, n2, false, mat1_wrap);
+
+    mm_packed(
+      n1, n2, n3, 1.0f, mat1_wrap, static_cast<float8_t const*>(mat2.data()), 0.0f, res, n3);
+}
+
+void
+mm_batched(int count,
+           int const* n1,
+           int const* n2,
+           int const* n3,
+           float const* const* mat1,
+           float const* const* mat2,
+           float* const* res)
+{
+    if (count == 0) {
+        return;
+    }
+
+    int ws_size = 0;
+    for (int b = 0; b < count; b++) {
+        ws_size = std::max(ws_size, packed_size(n1[b], n2[b]) + packed_size(n3[b], n2[b]));
+    }
+
+    // one workspace, big enough for the largest item, is shared by all items
+    float8_t* const ws =
+      static_cast<float8_t*>(aligned_alloc(sizeof(float8_t), ws_size * sizeof(float8_t)));
+
+    assert(ws);
+
+    for (int b = 0; b < count; b++) {
+        float8_t* const mat1_wrap = ws;
+        float8_t* const mat2_t_wrap = ws + packed_size(n1[b], n2[b]);
+
+        pack_mat1(n1[b], n2[b], mat1[b], n2[b], false, mat1_wrap);
+        pack_mat2(n2[b], n3[b], mat2[b], n3[b], false, mat2_t_wrap);
+
+        mm_packed(n1[b], n2[b], n3[b], 1.0f, mat1_wrap, mat2_t_wrap, 0.0f, res[b], n3[b]);
+    }
+
+    free(ws);
+}
+
+void
+mm_batched(int count,
+           int n1,
+           int n2,
+           int n3,
+           float const* mat1,
+           int stride1,
+           float const* mat2,
+           int stride2,
+           float* res,
+           int stride_res)
+{
+    float8_t* const mat1_wrap = alloc_packed(n1, n2);
+    float8_t* const mat2_t_wrap = alloc_packed(n3, n2);
+
+    for (int b = 0; b < count; b++) {
+        pack_mat1(n1, n2, mat1 + b * stride1, n2, false, mat1_wrap);
+
+        // with stride2 == 0 every item shares the same mat2, which is packed only once
+        if (b == 0 || stride2 != 0) {
+            pack_mat2(n2, n3, mat2 + b * stride2, n3, false, mat2_t_wrap);
+        }
+
+        mm_packed(n1, n2, n3, 1.0f, mat1_wrap, mat2_t_wrap, 0.0f, res + b * stride_res, n3);
+    }
+
+    free(mat1_wrap);
+    free(mat2_t_wrap);
+}
+
+CMPE492_REGISTER_KERNEL(mm_fn, mm);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
+} // namespace cmpe492
@@ -1,142 +1,693 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <cstdlib>
-#include <thread>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "mm.hpp"
+#include "mm_tuning.hpp"
+#include "registry.hpp"
 #include "simd.hpp"
+#include "thread_pool.hpp"
+#include "tuning.hpp"
+
+// the vector width can be chosen at compile time. mm_dispatch builds this file once per
+// instruction set, each copy in its own namespace named by CMPE492_NAMESPACE, and bench-mm
+// builds it into namespaces of its own too (see util/registry.hpp).
+#ifndef CMPE492_VECTOR_WIDTH
+#define CMPE492_VECTOR_WIDTH 8
+#endif
+
+// from here on compiled for the instruction set of the copy, see util/simd.hpp
+CMPE492_TARGET_BEGIN
 
 namespace cmpe492 {
 
+#ifdef CMPE492_NAMESPACE
+namespace CMPE492_NAMESPACE {
+#endif
+
 namespace {
 
-constexpr int nv = 8; // vector size
-constexpr int nu = 1; // unrolling constant
+using vector_t = vector_of<CMPE492_VECTOR_WIDTH>::type;
+using vector_unalgn_t = vector_of<CMPE492_VECTOR_WIDTH>::unalgn_type;
+
+constexpr int nv = CMPE492_VECTOR_WIDTH; // vector size
+constexpr int nu = 1;                    // unrolling constant
+
+/// cache blocking parameters, in the style of GotoBLAS/BLIS.
+/// kc is counted in packed vectors along n2, mc and nc in blocks of (nu * nv) rows/columns.
+/// kc is fixed since it is part of the packed layout, mc and nc are the defaults of mm_config.
+constexpr int kc = 4096 / nv; // a (nu * nv) x kc micro-panel is 16 KiB, the one of mat2 stays in L1
+constexpr int mc = 32;        // an mc x kc block of mat1_wrap is 512 KiB and stays in L2
+constexpr int nc = 512;       // a kc x nc panel of mat2_t_wrap is 8 MiB and stays in L3
+
+/// used for the shapes that are not tuned yet
+constexpr mm_config default_config = { mc, nc, 4 };
 
 } // namespace
 
 namespace {
+
+/// packed operands are split along n2 into blocks of kc.
+/// inside a depth block, the micro-panels of all n_blk row (or column) blocks are contiguous.
+/// returns the offset of the micro-panel of block i in the depth block starting at pc.
+inline int
+panel_offset(const int pc, const int i, const int n2, const int n_blk)
+{
+    const int len = std::min(kc, n2 - pc);
+    return (pc * n_blk + i * len) * nu;
+}
+
+/// the products of one step of the micro-kernel.
+/// lane w of t[m] is a[w ^ (m & ~1)] * b[w ^ (m & 1)], so the nv vectors of t cover all
+/// nv * nv products of a and b. for nv = 8 this is the shuffle pattern of mm_simd2.
+template<std::size_t... m>
+inline void
+fma_step(vector_t (&t)[nv], const vector_t a, const vector_t b, std::index_sequence<m...>)
+{
+    const vector_t b_1 = xor_shuffle<1>(b);
+
+    ((t[2 * m] += xor_shuffle<2 * m>(a) * b, t[2 * m + 1] += xor_shuffle<2 * m>(a) * b_1), ...);
+}
+
+/// multiply a micro-panel of mat1_wrap with a micro-panel of mat2_t_wrap, both of depth len,
+/// and update the result t in res (whose rows are ld_res apart) as res = alpha * t + beta * res.
+/// res is not read if beta is 0.
 void
-mm_helper(const int fr_row,
-          const int to_row,
-          const int n1,
-          const int n2,
-          const int n3,
-          const int n3r,
-          float8_t const* const mat1_wrap,
-          float8_t const* const mat2_t_wrap,
-          float* res)
-{
-    for (int i = fr_row; i < to_row; i++) {
-        for (int j = 0; j < n3r; j++) {
-            float8_t t[nu][nu][nv] = {};
-
-            for (int k = 0; k < n2; k++) {
-
-                for (int q1 = 0; q1 < nu; q1++) {
-                    for (int q2 = 0; q2 < nu; q2++) {
-                        float8_t v0_000 = mat1_wrap[(i * n2 * nu) + (k * nu) + (q1)];
-                        float8_t v1_000 = mat2_t_wrap[(j * n2 * nu) + (k * nu) + q2];
-
-                        float8_t v1_001 =
-                          __builtin_shufflevector(v1_000, v1_000, 1, 0, 3, 2, 5, 4, 7, 6);
-
-                        float8_t v0_100 =
-                          __builtin_shufflevector(v0_000, v0_000, 4, 5, 6, 7, 0, 1, 2, 3);
-                        float8_t v0_010 =
-                          __builtin_shufflevector(v0_000, v0_000, 2, 3, 0, 1, 6, 7, 4, 5);
-                        float8_t v0_110 =
-                          __builtin_shufflevector(v0_100, v0_100, 2, 3, 0, 1, 6, 7, 4, 5);
-
-                        t[q1][q2][0] += v0_000 * v1_000;
-                        t[q1][q2][1] += v0_000 * v1_001;
-                        t[q1][q2][2] += v0_010 * v1_000;
-                        t[q1][q2][3] += v0_010 * v1_001;
-                        t[q1][q2][4] += v0_100 * v1_000;
-                        t[q1][q2][5] += v0_100 * v1_001;
-                        t[q1][q2][6] += v0_110 * v1_000;
-                        t[q1][q2][7] += v0_110 * v1_001;
+micro_kernel(const int i,
+             const int j,
+             const int len,
+             const int n1,
+             const int n3,
+             vector_t const* const a,
+             vector_t const* const b,
+             const float alpha,
+             const float beta,
+             float* res,
+             const int ld_res)
+{
+    vector_t t[nu][nu][nv] = {};
+
+    for (int k = 0; k < len; k++) {
+
+        for (int q1 = 0; q1 < nu; q1++) {
+            for (int q2 = 0; q2 < nu; q2++) {
+                fma_step(t[q1][q2],
+                         a[(k * nu) + (q1)],
+                         b[(k * nu) + q2],
+                         std::make_index_sequence<nv / 2>{});
+            }
+        }
+    }
+
+    for (int q1 = 0; q1 < nu; q1++) {
+        for (int q2 = 0; q2 < nu; q2++) {
+            const int ri0 = i * (nu * nv) + q1 * nv;
+            const int rj0 = j * (nu * nv) + q2 * nv;
+
+            if (ri0 + nv <= n1 && rj0 + nv <= n3) {
+                // full tile: undo the shuffles on the stack, then update res row by row
+                float tile[nv][nv];
+
+                for (int w1 = 0; w1 < nv; w1++) {
+                    for (int w2 = 0; w2 < nv; w2++) {
+                        tile[w2 ^ (w1 & ~1)][w2 ^ (w1 & 1)] = t[q1][q2][w1][w2];
                     }
                 }
+
+                for (int w = 0; w < nv; w++) {
+                    vector_unalgn_t* const row =
+                      reinterpret_cast<vector_unalgn_t*>(&res[(ri0 + w) * ld_res + rj0]);
+                    vector_t tile_row = alpha * *reinterpret_cast<vector_unalgn_t*>(tile[w]);
+
+                    *row = (beta == 0.0f) ? tile_row : beta * *row + tile_row;
+                }
+                continue;
             }
 
-            for (int q1 = 0; q1 < nu; q1++) {
-                for (int q2 = 0; q2 < nu; q2++) {
+            for (int w1 = 0; w1 < nv; w1++) {
+                for (int w2 = 0; w2 < nv; w2++) {
+                    int ri = ri0 + w2 ^ (w1 & ~1);
+                    int rj = rj0 + w2 ^ (w1 & 1);
 
-                    for (int w1 = 0; w1 < nv; w1++) {
-                        for (int w2 = 0; w2 < nv; w2++) {
-                            int ri = i * (nu * nv) + q1 * nv + w2 ^ (w1 & 6);
-                            int rj = j * (nu * nv) + q2 * nv + w2 ^ (w1 & 1);
+                    if (ri < n1 && rj < n3) {
+                        float& r = res[ri * ld_res + rj];
+                        float v = alpha * t[q1][q2][w1][w2];
 
-                            if (ri < n1 && rj < n3) {
-                                res[ri * n3 + rj] = t[q1][q2][w1][w2];
-                            }
-                        }
+                        r = (beta == 0.0f) ? v : beta * r + v;
                     }
                 }
             }
         }
     }
 }
-} // namespace
 
+/// a unit of work for the scheduler: row blocks [i0, i1) and column blocks [j0, j1) of the result,
+/// restricted to the depth range [p0, p1), which starts at a multiple of kc.
+struct tile
+{
+    int i0, i1;
+    int j0, j1;
+    int p0, p1;
+};
+
+/// job for each worker thread, computes a tile t and updates out as out = alpha * t + beta * out.
+/// out is either res or a buffer for the partial result of a depth range.
 void
-mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
+mm_helper(tile const& tl,
+          const int n1,
+          const int n2,
+          const int n3,
+          const int n1r,
+          const int n3r,
+          const float alpha,
+          vector_t const* const mat1_wrap,
+          vector_t const* const mat2_t_wrap,
+          const float beta,
+          float* out,
+          const int ld_out)
 {
-    const int n1r = (n1 + nu * nv - 1) / (nu * nv);
-    const int n3r = (n3 + nu * nv - 1) / (nu * nv);
+    for (int pc = tl.p0; pc < tl.p1; pc += kc) {
+        const int len = std::min(kc, n2 - pc);
 
-    float8_t* const mat1_wrap =
-      static_cast<float8_t*>(aligned_alloc(sizeof(float8_t), n1r * n2 * nu * sizeof(float8_t)));
-    float8_t* const mat2_t_wrap =
-      static_cast<float8_t*>(aligned_alloc(sizeof(float8_t), n3r * n2 * nu * sizeof(float8_t)));
+        for (int j = tl.j0; j < tl.j1; j++) {
+            vector_t const* const b = mat2_t_wrap + panel_offset(pc, j, n2, n3r);
 
-    assert(mat1_wrap);
-    assert(mat2_t_wrap);
+            for (int i = tl.i0; i < tl.i1; i++) {
+                vector_t const* const a = mat1_wrap + panel_offset(pc, i, n2, n1r);
 
-    for (int i = 0; i < n1r; i++) {
-        for (int j = 0; j < n2; j++) {
-            for (int k1 = 0; k1 < nu; k1++) {
-                for (int k2 = 0; k2 < nv; k2++) {
-                    int row = (i * nu * nv + k1 * nv + k2);
+                // the first depth block applies beta, the later ones accumulate
+                const float b_pc = (pc == tl.p0) ? beta : 1.0f;
 
-                    mat1_wrap[(i * n2 * nu) + (j * nu) + (k1)][k2] =
-                      (row < n1) ? mat1[row * n2 + j] : 0.0f;
-                }
+                micro_kernel(i, j, len, n1, n3, a, b, alpha, b_pc, out, ld_out);
             }
         }
     }
+}
+
+/// pack block i of mat (rows by cols, row-major) so that each vector holds nv consecutive rows of
+/// a column, or with transpose set, nv consecutive columns of a row. out-of-range elements are 0.
+void
+pack(const int i,
+     const int n_blk,
+     const int n2,
+     const int n_lim,
+     float const* const mat,
+     const int ld,
+     const bool transpose,
+     vector_t* const wrap)
+{
+    for (int pc = 0; pc < n2; pc += kc) {
+        const int len = std::min(kc, n2 - pc);
+        vector_t* const panel = wrap + panel_offset(pc, i, n2, n_blk);
 
-    for (int i = 0; i < n3r; i++) {
-        for (int j = 0; j < n2; j++) {
+        for (int j = 0; j < len; j++) {
             for (int k1 = 0; k1 < nu; k1++) {
                 for (int k2 = 0; k2 < nv; k2++) {
-                    int col = (i * nu * nv + k1 * nv + k2);
+                    int idx = (i * nu * nv + k1 * nv + k2);
 
-                    mat2_t_wrap[(i * n2 * nu) + (j * nu) + (k1)][k2] =
-                      (col < n3) ? mat2[j * n3 + col] : 0.0f;
+                    if (idx >= n_lim) {
+                        panel[(j * nu) + (k1)][k2] = 0.0f;
+                    } else if (transpose) {
+                        panel[(j * nu) + (k1)][k2] = mat[(pc + j) * ld + idx];
+                    } else {
+                        panel[(j * nu) + (k1)][k2] = mat[idx * ld + pc + j];
+                    }
                 }
             }
         }
     }
+}
+
+/// number of vectors in the packed form of a matrix with n rows (or columns) and depth n2
+int
+packed_size(int n, int n2)
+{
+    return (n + nu * nv - 1) / (nu * nv) * n2 * nu;
+}
+
+vector_t*
+alloc_packed(int n, int n2)
+{
+    vector_t* const wrap = static_cast<vector_t*>(
+      aligned_alloc(sizeof(vector_t), packed_size(n, n2) * sizeof(vector_t)));
+
+    assert(wrap);
+
+    return wrap;
+}
+
+/// pack mat1, n1 by n2 (or n2 by n1 if trans1 is set) with rows ld1 apart
+void
+pack_mat1(int n1, int n2, float const* mat1, int ld1, bool trans1, vector_t* mat1_wrap)
+{
+    const int n1r = (n1 + nu * nv - 1) / (nu * nv);
+
+    parallel_for(0, n1r, [&](int i) { pack(i, n1r, n2, n1, mat1, ld1, trans1, mat1_wrap); });
+}
+
+/// pack mat2, n2 by n3 (or n3 by n2 if trans2 is set) with rows ld2 apart
+void
+pack_mat2(int n2, int n3, float const* mat2, int ld2, bool trans2, vector_t* mat2_t_wrap)
+{
+    const int n3r = (n3 + nu * nv - 1) / (nu * nv);
+
+    parallel_for(0, n3r, [&](int i) { pack(i, n3r, n2, n3, mat2, ld2, !trans2, mat2_t_wrap); });
+}
+
+/// the configuration set by mm_force_config(), if any. not synchronized, see mm_tuning.hpp.
+bool config_forced = false;
+mm_config forced_config = default_config;
+
+char const*
+tuning_name()
+{
+    static const std::string name = "mm_simd2_mt_w" + std::to_string(nv);
+    return name.c_str();
+}
+
+/// the configuration for the shape, see mm_get_config()
+mm_config
+config_for(int n1, int n2, int n3)
+{
+    if (config_forced) {
+        return forced_config;
+    }
+
+    const tuning_cache::shape_t shape = { size_class(n1), size_class(n2), size_class(n3) };
+
+    // the configurations of the shape classes looked up before, so that a call does not take the
+    // lock of the cache and copy its entry. per thread, a slot per class, emptied (mc = 0) when
+    // the autotuner stores an entry.
+    static thread_local std::array<std::pair<tuning_cache::shape_t, mm_config>, 16> seen = {};
+    static thread_local unsigned seen_version = 0;
+
+    auto& cache = tuning_cache::instance();
+    const unsigned version = cache.version();
+    if (version != seen_version) {
+        seen = {};
+        seen_version = version;
+    }
+
+    auto& slot = seen[(shape[0] * 64 * 64 + shape[1] * 64 + shape[2]) % seen.size()];
+    if (slot.second.mc != 0 && slot.first == shape) {
+        return slot.second;
+    }
+
+    const auto params = cache.lookup(tuning_name(), shape);
+
+    // the cache is a text file that can be edited by hand, a tile of no micro-tiles would divide
+    // by zero in mm_packed()
+    mm_config cfg = default_config;
+    if (params.size() == 3 && params[0] >= 1 && params[1] >= 1 && params[2] >= 1) {
+        cfg = { params[0], params[1], params[2] };
+    }
+
+    slot = { shape, cfg };
+    return cfg;
+}
+
+/// res = alpha * mat1 * mat2 + beta * res for the packed matrices,
+/// splitting the work into tasks for num_thr threads as given by cfg
+void
+mm_packed(int n1,
+          int n2,
+          int n3,
+          const float alpha,
+          vector_t const* const mat1_wrap,
+          vector_t const* const mat2_t_wrap,
+          const float beta,
+          float* res,
+          const int ld_res,
+          mm_config const& cfg,
+          const int num_thr = get_num_threads())
+{
+    if (n2 == 0) {
+        for (int i = 0; i < n1; i++) {
+            for (int j = 0; j < n3; j++) {
+                res[i * ld_res + j] = (beta == 0.0f) ? 0.0f : beta * res[i * ld_res + j];
+            }
+        }
+        return;
+    }
+
+    if (n1 == 0 || n3 == 0) {
+        return;
+    }
+
+    const int n1r = (n1 + nu * nv - 1) / (nu * nv);
+    const int n3r = (n3 + nu * nv - 1) / (nu * nv);
 
-    const int num_thr = 4;
-    std::vector<std::thread> threads(num_thr);
+    // split the result into a 2d grid of tiles, which are shrunk (down to a single micro-tile)
+    // until there are enough of them to balance the load among the threads
+    int tm = std::min(cfg.mc, n1r);
+    int tn = std::min(cfg.nc, n3r);
 
-    for (int i = 0; i < num_thr; i++) {
-        int beg = i * ((n1r + num_thr - 1) / num_thr);
-        int end = (i + 1) * ((n1r + num_thr - 1) / num_thr);
-        end = std::min(end, n1r);
+    auto num_tiles = [&] { return ((n1r + tm - 1) / tm) * ((n3r + tn - 1) / tn); };
 
-        threads[i] = std::thread(mm_helper, beg, end, n1, n2, n3, n3r, mat1_wrap, mat2_t_wrap, res);
+    while (num_tiles() < cfg.split * num_thr && (tm > 1 || tn > 1)) {
+        if (tn >= tm) {
+            tn = (tn + 1) / 2;
+        } else {
+            tm = (tm + 1) / 2;
+        }
     }
 
-    for (int i = 0; i < num_thr; i++) {
-        threads[i].join();
+    const int n_tm = (n1r + tm - 1) / tm;
+    const int n_tiles = num_tiles();
+
+    // if there are still fewer tiles than threads, also split the depth, in multiples of kc.
+    // each depth range except the first accumulates into its own buffer, summed up at the end.
+    const int n_kb = (n2 + kc - 1) / kc;
+    const int ks = std::min(n_kb, (num_thr + n_tiles - 1) / n_tiles);
+
+    std::vector<float> partial((ks - 1) * n1 * n3);
+
+    // tasks are handed out in order by the pool's atomic counter.
+    // consecutive tasks share the same column tile, so they reuse the same panel of mat2_t_wrap.
+    parallel_for(0, ks * n_tiles, [&](int t) {
+        const int c = t / n_tiles;
+        const int ti = t % n_tiles % n_tm;
+        const int tj = t % n_tiles / n_tm;
+
+        tile tl;
+        tl.i0 = ti * tm;
+        tl.i1 = std::min(tl.i0 + tm, n1r);
+        tl.j0 = tj * tn;
+        tl.j1 = std::min(tl.j0 + tn, n3r);
+        tl.p0 = c * n_kb / ks * kc;
+        tl.p1 = std::min((c + 1) * n_kb / ks * kc, n2);
+
+        if (c == 0) {
+            mm_helper(tl, n1, n2, n3, n1r, n3r, alpha, mat1_wrap, mat2_t_wrap, beta, res, ld_res);
+        } else {
+            float* const out = partial.data() + (c - 1) * n1 * n3;
+
+            mm_helper(tl, n1, n2, n3, n1r, n3r, alpha, mat1_wrap, mat2_t_wrap, 0.0f, out, n3);
+        }
+    });
+
+    if (ks > 1) {
+        parallel_for(0, n1, [&](int i) {
+            for (int c = 1; c < ks; c++) {
+                float const* const p = partial.data() + (c - 1) * n1 * n3;
+
+                for (int j = 0; j < n3; j++) {
+                    res[i * ld_res + j] += p[i * n3 + j];
+                }
+            }
+        });
     }
+}
+
+/// sgemm() on plain matrices.
+/// the public functions only call functions of this namespace, so that in the per-isa builds
+/// they cannot end up calling the dispatching versions from mm.hpp.
+void
+gemm(bool trans1,
+     bool trans2,
+     int n1,
+     int n2,
+     int n3,
+     float alpha,
+     float const* mat1,
+     int ld1,
+     float const* mat2,
+     int ld2,
+     float beta,
+     float* res,
+     int ld_res)
+{
+    vector_t* const mat1_wrap = alloc_packed(n1, n2);
+    vector_t* const mat2_t_wrap = alloc_packed(n3, n2);
+
+    // the transposes are handled while packing
+    pack_mat1(n1, n2, mat1, ld1, trans1, mat1_wrap);
+    pack_mat2(n2, n3, mat2, ld2, trans2, mat2_t_wrap);
+
+    mm_packed(
+      n1, n2, n3, alpha, mat1_wrap, mat2_t_wrap, beta, res, ld_res, config_for(n1, n2, n3));
 
     free(mat1_wrap);
     free(mat2_t_wrap);
 }
 
-} // namespace cmpe492
\ No newline at end of file
+/// multiply the items of a batch on num_thr threads, each with its own part of one workspace.
+/// each thread picks the next item with an atomic counter and calls
+/// item(b, ws) where ws has room for ws_size vectors.
+template<typename Func>
+void
+run_batched(int count, int ws_size, Func&& item)
+{
+    const int num_thr = std::min(get_num_threads(), count);
+
+    std::unique_ptr<void, decltype(&free)> workspace(
+      aligned_alloc(sizeof(vector_t), std::max(1, num_thr * ws_size) * sizeof(vector_t)), &free);
+
+    assert(workspace);
+
+    std::atomic<int> next{ 0 };
+
+    parallel_for(0, num_thr, [&](int thr) {
+        vector_t* const ws = static_cast<vector_t*>(workspace.get()) + thr * ws_size;
+
+        for (int b = next++; b < count; b = next++) {
+            item(b, ws);
+        }
+    });
+}
+
+} // namespace
+
+void
+mm(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
+{
+    gemm(false, false, n1, n2, n3, 1.0f, mat1, n2, mat2, n3, 0.0f, res, n3);
+}
+
+void
+sgemm(transpose trans1,
+      transpose trans2,
+      int n1,
+      int n2,
+      int n3,
+      float alpha,
+      float const* mat1,
+      int ld1,
+      float const* mat2,
+      int ld2,
+      float beta,
+      float* res,
+      int ld_res)
+{
+    gemm(trans1 == transpose::yes,
+         trans2 == transpose::yes,
+         n1,
+         n2,
+         n3,
+         alpha,
+         mat1,
+         ld1,
+         mat2,
+         ld2,
+         beta,
+         res,
+         ld_res);
+}
+
+packed_matrix
+pack_lhs(int n1, int n2, float const* mat1)
+{
+    vector_t* const mat1_wrap = alloc_packed(n1, n2);
+    pack_mat1(n1, n2, mat1, n2, false, mat1_wrap);
+
+    return packed_matrix(n1, n2, true, mat1_wrap);
+}
+
+packed_matrix
+pack_rhs(int n2, int n3, float const* mat2)
+{
+    vector_t* const mat2_t_wrap = alloc_packed(n3, n2);
+    pack_mat2(n2, n3, mat2, n3, false, mat2_t_wrap);
+
+    return packed_matrix(n2, n3, false, mat2_t_wrap);
+}
+
+void
+mm(packed_matrix const& mat1, packed_matrix const& mat2, float* res)
+{
+    assert(mat1.is_lhs() && !mat2.is_lhs());
+    assert(mat1.cols() == mat2.rows());
+
+    mm_packed(mat1.rows(),
+              mat1.cols(),
+              mat2.cols(),
+              1.0f,
+              static_cast<vector_t const*>(mat1.data()),
+              static_cast<vector_t const*>(mat2.data()),
+              0.0f,
+              res,
+              mat2.cols(),
+              config_for(mat1.rows(), mat1.cols(), mat2.cols()));
+}
+
+void
+mm(int n1, float const* mat1, packed_matrix const& mat2, float* res)
+{
+    assert(!mat2.is_lhs());
+
+    const int n2 = mat2.rows();
+    const int n3 = mat2.cols();
+
+    // mat1 is packed into a buffer that is kept between the calls
+    static thread_local std::unique_ptr<void, decltype(&free)> workspace(nullptr, &free);
+    static thread_local int workspace_size = 0;
+
+    if (workspace_size < packed_size(n1, n2)) {
+        workspace.reset(alloc_packed(n1, n2));
+        workspace_size = packed_size(n1, n2);
+    }
+
+    vector_t* const mat1_wrap = static_cast<vector_t*>(workspace.get());
+    pack_mat1(n1, n2, mat1, n2, false, mat1_wrap);
+
+    mm_packed(n1,
+              n2,
+              n3,
+              1.0f,
+              mat1_wrap,
+              static_cast<vector_t const*>(mat2.data()),
+              0.0f,
+              res,
+              n3,
+              config_for(n1, n2, n3));
+}
+
+void
+mm_batched(int count,
+           int const* n1,
+           int const* n2,
+           int const* n3,
+           float const* const* mat1,
+           float const* const* mat2,
+           float* const* res)
+{
+    int ws_size = 0;
+    for (int b = 0; b < count; b++) {
+        ws_size = std::max(ws_size, packed_size(n1[b], n2[b]) + packed_size(n3[b], n2[b]));
+    }
+
+    // the items are small, so each one is computed by a single thread
+    run_batched(count, ws_size, [&](int b, vector_t* ws) {
+        vector_t* const mat1_wrap = ws;
+        vector_t* const mat2_t_wrap = ws + packed_size(n1[b], n2[b]);
+
+        pack_mat1(n1[b], n2[b], mat1[b], n2[b], false, mat1_wrap);
+        pack_mat2(n2[b], n3[b], mat2[b], n3[b], false, mat2_t_wrap);
+
+        mm_packed(n1[b],
+                  n2[b],
+                  n3[b],
+                  1.0f,
+                  mat1_wrap,
+                  mat2_t_wrap,
+                  0.0f,
+                  res[b],
+                  n3[b],
+                  default_config,
+                  1);
+    });
+}
+
+void
+mm_batched(int count,
+           int n1,
+           int n2,
+           int n3,
+           float const* mat1,
+           int stride1,
+           float const* mat2,
+           int stride2,
+           float* res,
+           int stride_res)
+{
+    if (stride2 == 0) {
+        // the same mat2 for every item, pack it once
+        vector_t* const mat2_t_wrap = alloc_packed(n3, n2);
+        pack_mat2(n2, n3, mat2, n3, false, mat2_t_wrap);
+
+        run_batched(count, packed_size(n1, n2), [&](int b, vector_t* ws) {
+            pack_mat1(n1, n2, mat1 + b * stride1, n2, false, ws);
+            mm_packed(n1,
+                      n2,
+                      n3,
+                      1.0f,
+                      ws,
+                      mat2_t_wrap,
+                      0.0f,
+                      res + b * stride_res,
+                      n3,
+                      default_config,
+                      1);
+        });
+
+        free(mat2_t_wrap);
+        return;
+    }
+
+    run_batched(count, packed_size(n1, n2) + packed_size(n3, n2), [&](int b, vector_t* ws) {
+        vector_t* const mat1_wrap = ws;
+        vector_t* const mat2_t_wrap = ws + packed_size(n1, n2);
+
+        pack_mat1(n1, n2, mat1 + b * stride1, n2, false, mat1_wrap);
+        pack_mat2(n2, n3, mat2 + b * stride2, n3, false, mat2_t_wrap);
+
+        mm_packed(n1,
+                  n2,
+                  n3,
+                  1.0f,
+                  mat1_wrap,
+                  mat2_t_wrap,
+                  0.0f,
+                  res + b * stride_res,
+                  n3,
+                  default_config,
+                  1);
+    });
+}
+
+mm_config
+mm_get_config(int n1, int n2, int n3)
+{
+    return config_for(n1, n2, n3);
+}
+
+void
+mm_force_config(mm_config const* cfg)
+{
+    config_forced = (cfg != nullptr);
+    if (cfg) {
+        forced_config = *cfg;
+    }
+}
+
+char const*
+mm_tuning_name()
+{
+    return tuning_name();
+}
+
+CMPE492_TARGET_END
+
+CMPE492_REGISTER_KERNEL(mm_fn, mm);
+
+#ifdef CMPE492_NAMESPACE
+} // namespace CMPE492_NAMESPACE
+#endif
+
+} // namespace cmpe492
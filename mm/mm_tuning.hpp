@@ -0,0 +1,30 @@
+#pragma once
+
+namespace cmpe492 {
+
+/// runtime parameters of the multi-threaded mm kernel (mm_simd2_mt).
+/// mc and nc are the size of a tile of the result in micro-tiles, and the tiles are shrunk until
+/// there are at least split tiles per thread.
+struct mm_config
+{
+    int mc;
+    int nc;
+    int split;
+};
+
+/// the configuration that mm() and sgemm() use for the shape: the one found by the autotuner for
+/// its shape class on this cpu (see tuning.hpp), or the default one
+mm_config
+mm_get_config(int n1, int n2, int n3);
+
+/// use cfg for all the following calls instead of looking it up, or stop doing so if cfg is null.
+/// used by the autotuner to measure the candidates. not synchronized with the calls, it must not
+/// be called while other threads are running the kernel.
+void
+mm_force_config(mm_config const* cfg);
+
+/// name of the kernel in the tuning cache, includes the vector width
+char const*
+mm_tuning_name();
+
+} // namespace cmpe492
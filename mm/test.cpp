@@ -65,6 +65,11 @@ get_cases()
                 cases.emplace_back(i + 50, j + 50, k + 50);
             }
 
+    // skinny shapes, where the work has to be split along n3 or n2 to keep all threads busy
+    cases.emplace_back(16, 1000, 1000);
+    cases.emplace_back(1000, 1000, 16);
+    cases.emplace_back(9, 3000, 13);
+
     // sort by complexity
     sort(cases.begin(), cases.end(), [](tup3 x, tup3 y) {
         return std::get<0>(x) * std::get<1>(x) * std::get<2>(x) <
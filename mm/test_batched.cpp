@@ -0,0 +1,150 @@
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "generator.hpp"
+#include "mm.hpp"
+
+constexpr std::string_view ok = "[\033[32;1m  OK  \033[0m]";
+constexpr std::string_view fail = "[\033[31;1m FAIL \033[0m]";
+
+bool
+check(int n1, int n2, int n3, float const* mat1, float const* mat2, float const* res)
+{
+    constexpr long double tolerance = 1e-6;
+
+    for (int i = 0; i < n1; i++) {
+        for (int j = 0; j < n3; j++) {
+            float r = res[i * n3 + j];
+
+            if (r != r) { // nan
+                return false;
+            }
+
+            long double t = 0;
+
+            for (int k = 0; k < n2; k++) {
+                t += (long double)mat1[i * n2 + k] * mat2[k * n3 + j];
+            }
+
+            long double err = t - r;
+            err = err * err / n2;
+
+            if (err > tolerance) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/// uniform shapes, with a separate mat2 per item or (shared_mat2) the same one for all
+bool
+test_strided(int count, int n1, int n2, int n3, bool shared_mat2)
+{
+    // leave a gap between the items to test the strides
+    const int stride1 = n1 * n2 + 3;
+    const int stride2 = shared_mat2 ? 0 : n2 * n3 + 5;
+    const int stride_res = n1 * n3 + 7;
+
+    std::vector<float> mat1(count * stride1);
+    std::vector<float> mat2(shared_mat2 ? n2 * n3 : count * stride2);
+    std::vector<float> res(count * stride_res);
+
+    cmpe492::random_fill(mat1.begin(), mat1.end());
+    cmpe492::random_fill(mat2.begin(), mat2.end());
+
+    cmpe492::mm_batched(
+      count, n1, n2, n3, mat1.data(), stride1, mat2.data(), stride2, res.data(), stride_res);
+
+    for (int b = 0; b < count; b++) {
+        if (!check(n1,
+                   n2,
+                   n3,
+                   mat1.data() + b * stride1,
+                   mat2.data() + b * stride2,
+                   res.data() + b * stride_res)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// a different shape for each item
+bool
+test_grouped(int count)
+{
+    std::vector<int> n1(count), n2(count), n3(count);
+    std::vector<std::vector<float>> mat1(count), mat2(count), res(count);
+    std::vector<float const*> mat1_ptr(count), mat2_ptr(count);
+    std::vector<float*> res_ptr(count);
+
+    for (int b = 0; b < count; b++) {
+        n1[b] = 1 + b % 13;
+        n2[b] = 1 + b * 7 % 64;
+        n3[b] = 1 + b * 5 % 40;
+
+        mat1[b].resize(n1[b] * n2[b]);
+        mat2[b].resize(n2[b] * n3[b]);
+        res[b].resize(n1[b] * n3[b]);
+
+        cmpe492::random_fill(mat1[b].begin(), mat1[b].end());
+        cmpe492::random_fill(mat2[b].begin(), mat2[b].end());
+
+        mat1_ptr[b] = mat1[b].data();
+        mat2_ptr[b] = mat2[b].data();
+        res_ptr[b] = res[b].data();
+    }
+
+    cmpe492::mm_batched(
+      count, n1.data(), n2.data(), n3.data(), mat1_ptr.data(), mat2_ptr.data(), res_ptr.data());
+
+    for (int b = 0; b < count; b++) {
+        if (!check(n1[b], n2[b], n3[b], mat1_ptr[b], mat2_ptr[b], res_ptr[b])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int
+main()
+{
+    bool ever_failed = false;
+
+    auto report = [&](bool check_res) {
+        if (!check_res)
+            ever_failed = true;
+
+        std::cout << (check_res ? ok : fail) << std::endl;
+    };
+
+    for (int n : { 1, 7, 8, 9, 16, 33, 64 }) {
+        for (bool shared_mat2 : { false, true }) {
+            std::cout << "strided " << std::setw(4) << n << (shared_mat2 ? " shared" : "       ")
+                      << "\t\t" << std::flush;
+
+            report(test_strided(50, n, n + 1, n, shared_mat2));
+        }
+    }
+
+    for (int count : { 0, 1, 10, 100 }) {
+        std::cout << "grouped " << std::setw(4) << count << "\t\t\t" << std::flush;
+
+        report(test_grouped(count));
+    }
+
+    if (ever_failed) {
+        std::cerr << "\033[31;1mSome tests have failed!\033[0m" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
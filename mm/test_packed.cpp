@@ -0,0 +1,123 @@
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+#include "generator.hpp"
+#include "mm.hpp"
+
+constexpr std::string_view ok = "[\033[32;1m  OK  \033[0m]";
+constexpr std::string_view fail = "[\033[31;1m FAIL \033[0m]";
+
+bool
+check(int n1, int n2, int n3, float const* mat1, float const* mat2, float const* res)
+{
+    constexpr long double tolerance = 1e-6;
+
+    for (int i = 0; i < n1; i++) {
+        for (int j = 0; j < n3; j++) {
+            float r = res[i * n3 + j];
+
+            if (r != r) { // nan
+                return false;
+            }
+
+            long double t = 0;
+
+            for (int k = 0; k < n2; k++) {
+                t += (long double)mat1[i * n2 + k] * mat2[k * n3 + j];
+            }
+
+            long double err = t - r;
+            err = err * err / n2;
+
+            if (err > tolerance) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/// pack mat2 once and multiply it with a few different mat1s,
+/// both with a prepacked mat1 and with a plain one
+bool
+test_packed(int n1, int n2, int n3)
+{
+    std::vector<float> mat2(n2 * n3);
+    cmpe492::random_fill(mat2.begin(), mat2.end());
+
+    cmpe492::packed_matrix mat2_packed = cmpe492::pack_rhs(n2, n3, mat2.data());
+
+    for (int rep = 0; rep < 3; rep++) {
+        std::vector<float> mat1(n1 * n2);
+        std::vector<float> res(n1 * n3);
+
+        cmpe492::random_fill(mat1.begin(), mat1.end());
+
+        cmpe492::mm(n1, mat1.data(), mat2_packed, res.data());
+
+        if (!check(n1, n2, n3, mat1.data(), mat2.data(), res.data())) {
+            return false;
+        }
+
+        cmpe492::packed_matrix mat1_packed = cmpe492::pack_lhs(n1, n2, mat1.data());
+        std::fill(res.begin(), res.end(), 0.0f);
+
+        cmpe492::mm(mat1_packed, mat2_packed, res.data());
+
+        if (!check(n1, n2, n3, mat1.data(), mat2.data(), res.data())) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::vector<std::tuple<int, int, int>> cases;
+
+    if (argc == 1) {
+        for (int i : { 1, 7, 8, 9, 58 }) {
+            for (int j : { 1, 7, 8, 9, 58 }) {
+                for (int k : { 1, 7, 8, 9, 58 }) {
+                    cases.emplace_back(i, j, k);
+                }
+            }
+        }
+        cases.emplace_back(100, 1000, 30);
+    } else if (argc == 4) {
+        cases.emplace_back(std::atoi(argv[1]), std::atoi(argv[2]), std::atoi(argv[3]));
+    } else {
+        std::cout << "usage: " << argv[0] << " [n1 n2 n3]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool ever_failed = false;
+
+    for (auto [n1, n2, n3] : cases) {
+        std::cout << std::setw(4) << n1 << " " << std::setw(4) << n2 << " " << std::setw(4) << n3
+                  << "\t\t" << std::flush;
+
+        bool check_res = test_packed(n1, n2, n3);
+
+        if (!check_res)
+            ever_failed = true;
+
+        std::cout << (check_res ? ok : fail) << std::endl;
+    }
+
+    if (ever_failed) {
+        std::cerr << "\033[31;1mSome tests have failed!\033[0m" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+#include "generator.hpp"
+#include "mm.hpp"
+#include "thread_pool.hpp"
+
+constexpr std::string_view ok = "[\033[32;1m  OK  \033[0m]";
+constexpr std::string_view fail = "[\033[31;1m FAIL \033[0m]";
+
+using cmpe492::transpose;
+
+/// run sgemm on operands stored with padded rows, and compare it with a reference computation
+bool
+test_sgemm(transpose trans1, transpose trans2, int n1, int n2, int n3, float alpha, float beta)
+{
+    constexpr long double tolerance = 1e-6;
+    constexpr int pad = 5;
+
+    const bool t1 = trans1 == transpose::yes;
+    const bool t2 = trans2 == transpose::yes;
+
+    // stored shapes
+    const int rows1 = t1 ? n2 : n1, cols1 = t1 ? n1 : n2;
+    const int rows2 = t2 ? n3 : n2, cols2 = t2 ? n2 : n3;
+    const int ld1 = cols1 + pad, ld2 = cols2 + pad, ld_res = n3 + pad;
+
+    std::vector<float> mat1(rows1 * ld1);
+    std::vector<float> mat2(rows2 * ld2);
+    std::vector<float> res(n1 * ld_res);
+
+    cmpe492::random_fill(mat1.begin(), mat1.end());
+    cmpe492::random_fill(mat2.begin(), mat2.end());
+
+    if (beta == 0.0f) {
+        // res must not be read
+        std::fill(res.begin(), res.end(), std::numeric_limits<float>::quiet_NaN());
+    } else {
+        cmpe492::random_fill(res.begin(), res.end());
+    }
+
+    std::vector<float> res_orig = res;
+
+    cmpe492::sgemm(trans1,
+                   trans2,
+                   n1,
+                   n2,
+                   n3,
+                   alpha,
+                   mat1.data(),
+                   ld1,
+                   mat2.data(),
+                   ld2,
+                   beta,
+                   res.data(),
+                   ld_res);
+
+    for (int i = 0; i < n1; i++) {
+        for (int j = 0; j < ld_res; j++) {
+            float r = res[i * ld_res + j];
+
+            if (j >= n3) {
+                // the padding must be left untouched
+                if (r != res_orig[i * ld_res + j] && r == r) {
+                    return false;
+                }
+                continue;
+            }
+
+            if (r != r) { // nan
+                return false;
+            }
+
+            long double t = 0;
+
+            for (int k = 0; k < n2; k++) {
+                long double a = t1 ? mat1[k * ld1 + i] : mat1[i * ld1 + k];
+                long double b = t2 ? mat2[j * ld2 + k] : mat2[k * ld2 + j];
+                t += a * b;
+            }
+
+            t = alpha * t;
+            if (beta != 0.0f) {
+                t += (long double)beta * res_orig[i * ld_res + j];
+            }
+
+            long double err = t - r;
+            err = err * err / std::max(n2, 1);
+
+            if (err > tolerance) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int
+main()
+{
+    bool ever_failed = false;
+
+    const std::tuple<float, float> scalars[] = { { 1.0f, 0.0f }, { 0.5f, 2.0f }, { -1.0f, 1.0f } };
+
+    // a depth of 1100 is more than one block of the packed kernels (kc), where beta applies to the
+    // first block only. with several threads, the few tiles of the small results also split the
+    // depth, whose ranges are summed up at the end.
+    for (int n_thr : { 1, 4 }) {
+        cmpe492::set_num_threads(n_thr);
+
+        for (transpose trans1 : { transpose::no, transpose::yes }) {
+            for (transpose trans2 : { transpose::no, transpose::yes }) {
+                for (int n1 : { 1, 8, 9, 58 }) {
+                    for (int n2 : { 1, 7, 58, 1100 }) {
+                        for (int n3 : { 1, 8, 13, 58 }) {
+                            for (auto [alpha, beta] : scalars) {
+                                std::cout
+                                  << n_thr << " " << (trans1 == transpose::yes ? "T" : "N")
+                                  << (trans2 == transpose::yes ? "T" : "N") << " " << std::setw(4)
+                                  << n1 << " " << std::setw(4) << n2 << " " << std::setw(4) << n3
+                                  << " " << std::setw(4) << alpha << " " << std::setw(4) << beta
+                                  << "\t\t" << std::flush;
+
+                                bool check_res =
+                                  test_sgemm(trans1, trans2, n1, n2, n3, alpha, beta);
+
+                                if (!check_res)
+                                    ever_failed = true;
+
+                                std::cout << (check_res ? ok : fail) << std::endl;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (ever_failed) {
+        std::cerr << "\033[31;1mSome tests have failed!\033[0m" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
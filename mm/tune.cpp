@@ -0,0 +1,106 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+#include "generator.hpp"
+#include "mm.hpp"
+#include "mm_tuning.hpp"
+#include "tuning.hpp"
+
+namespace {
+
+/// best running time of a few calls, in seconds
+double
+measure(int n1, int n2, int n3, float const* mat1, float const* mat2, float* res)
+{
+    using clock = std::chrono::steady_clock;
+
+    cmpe492::mm(n1, n2, n3, mat1, mat2, res); // warm up
+
+    double best = 1e100;
+    for (int r = 0; r < 3; r++) {
+        const auto start = clock::now();
+        cmpe492::mm(n1, n2, n3, mat1, mat2, res);
+        best = std::min(best, std::chrono::duration<double>(clock::now() - start).count());
+    }
+
+    return best;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    using tup3 = std::tuple<int, int, int>;
+    std::vector<tup3> shapes;
+
+    if (argc == 1) {
+        shapes = { { 256, 256, 256 }, { 1000, 1000, 1000 }, { 2000, 2000, 2000 } };
+    } else if (argc % 3 == 1) {
+        for (int i = 1; i < argc; i += 3) {
+            shapes.emplace_back(std::atoi(argv[i]), std::atoi(argv[i + 1]), std::atoi(argv[i + 2]));
+        }
+    } else {
+        std::cout << "usage: " << argv[0] << " [n1 n2 n3]..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto& cache = cmpe492::tuning_cache::instance();
+
+    std::cout << "cpu: " << cmpe492::cpu_model() << "\nkernel: " << cmpe492::mm_tuning_name()
+              << "\ncache: " << cache.path() << std::endl;
+
+    std::vector<cmpe492::mm_config> candidates;
+    for (int mc : { 8, 16, 32, 64 }) {
+        for (int nc : { 128, 256, 512, 1024 }) {
+            for (int split : { 1, 4, 16 }) {
+                candidates.push_back({ mc, nc, split });
+            }
+        }
+    }
+
+    for (auto [n1, n2, n3] : shapes) {
+        std::vector<float> mat1(n1 * n2);
+        std::vector<float> mat2(n2 * n3);
+        std::vector<float> res(n1 * n3);
+
+        cmpe492::random_fill(mat1.begin(), mat1.end());
+        cmpe492::random_fill(mat2.begin(), mat2.end());
+
+        const cmpe492::mm_config current = cmpe492::mm_get_config(n1, n2, n3);
+        const double current_time = measure(n1, n2, n3, mat1.data(), mat2.data(), res.data());
+
+        cmpe492::mm_config best = current;
+        double best_time = current_time;
+
+        for (auto const& cfg : candidates) {
+            cmpe492::mm_force_config(&cfg);
+            const double t = measure(n1, n2, n3, mat1.data(), mat2.data(), res.data());
+
+            if (t < best_time) {
+                best = cfg;
+                best_time = t;
+            }
+        }
+        cmpe492::mm_force_config(nullptr);
+
+        std::cout << std::setprecision(4) << std::fixed << n1 << " " << n2 << " " << n3
+                  << "\tmc nc split: " << best.mc << " " << best.nc << " " << best.split << "\t"
+                  << best_time << " s (was " << current_time << " s)" << std::endl;
+
+        const cmpe492::tuning_cache::shape_t shape = { cmpe492::size_class(n1),
+                                                       cmpe492::size_class(n2),
+                                                       cmpe492::size_class(n3) };
+
+        if (!cache.store(cmpe492::mm_tuning_name(), shape, { best.mc, best.nc, best.split })) {
+            std::cout << "cannot write " << cache.path() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    return 0;
+}
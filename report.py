@@ -5,6 +5,7 @@ import argparse
 import re
 import time
 import csv
+import json
 import http.server
 import socketserver
 import threading
@@ -23,11 +24,18 @@ class Platform:
         os.makedirs(build_dir, exist_ok=True)
         self._do_configure()
 
-    def _parse_running_time(self, benchmark_out: str) -> float:
+    # statistics of a benchmark run, from the json line of util/bench.hpp if there is one,
+    # otherwise the running time of a single call
+    def _parse_benchmark(self, benchmark_out: str) -> dict:
+        for line in benchmark_out.split('\n'):
+            m = re.match(r'^json:\s+(\{.*\})', line)
+            if m:
+                return json.loads(m.group(1))
         for line in benchmark_out.split('\n'):
             m = re.match(r'^running time:\s+([\d\.]+)', line)
             if m:
-                return float(m.group(1))
+                rt = float(m.group(1))
+                return {'median': rt, 'min': rt, 'p90': rt, 'samples': 1}
         raise RuntimeError('unexpected benchmark output')
 
     def build(self, task: str, version: str):
@@ -46,7 +54,8 @@ class Platform:
         if not success:
             raise TestFailedError()
 
-    def benchmark(self, task: str, version: str, n_repeat=1, skip_tests=False) -> List[float]:
+    def benchmark(self, task: str, version: str, n_repeat=1, skip_tests=False,
+                  shape: List[int] = None) -> List[dict]:
         self.build(task, version)
 
         if not skip_tests:
@@ -54,13 +63,26 @@ class Platform:
 
         print(f'Benchmarking {task}_{version} on platform "{self.name}" ...')
 
-        running_times = []
+        runs = []
 
         for i in range(n_repeat):
-            rt = self._do_benchmark(task, version)
-            print(f'Benchmark {i+1}:', rt)
-            running_times.append(rt)
-        return running_times
+            run = self._do_benchmark(task, version, [str(n) for n in shape or []])
+            print(f'Benchmark {i+1}:', run['median'])
+            runs.append(run)
+        return runs
+
+    # the roofs measured by misc/roofline.cpp: peak GFLOP/s and GB/s, on 1 thread and on all
+    def roofline(self) -> dict:
+        print(f'Measuring the roofline of platform "{self.name}" ...')
+
+        subprocess.check_call([
+            'cmake',
+            '--build', '.',
+            '--target', 'roofline',
+            '--parallel', '2',
+        ], cwd=self.build_dir, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+        return self._parse_benchmark(self._do_roofline())
 
     def close(self):
         self._do_close()
@@ -71,9 +93,12 @@ class Platform:
     def _do_test(self, task: str, version: str):
         raise NotImplementedError
 
-    def _do_benchmark(self, task: str, version: str) -> float:
+    def _do_benchmark(self, task: str, version: str, args: List[str]) -> dict:
         raise NotImplementedError
 
+    def _do_roofline(self) -> str:
+        raise NotImplementedError(f'no roofline for platform "{self.name}"')
+
     def _do_close(self):
         pass
 
@@ -97,11 +122,14 @@ class Native(Platform):
         except subprocess.CalledProcessError:
             return False
 
-    def _do_benchmark(self, task: str, version: str) -> float:
+    def _do_benchmark(self, task: str, version: str, args: List[str]) -> dict:
         output = subprocess.check_output(
-            [f'./{task}/bench-{task}_{version}'], cwd=self.build_dir)
+            [f'./{task}/bench-{task}_{version}'] + args, cwd=self.build_dir)
         output = output.decode()
-        return self._parse_running_time(output)
+        return self._parse_benchmark(output)
+
+    def _do_roofline(self) -> str:
+        return subprocess.check_output(['./misc/roofline'], cwd=self.build_dir).decode()
 
 
 class BrowserBase(Platform):
@@ -137,9 +165,14 @@ class BrowserBase(Platform):
         output_text = self._run_and_get_output('{task}/test-{task}_{version}.html')
         return not ('FAIL' in output_text)
 
-    def _do_benchmark(self, task: str, version: str):
+    def _do_benchmark(self, task: str, version: str, args: List[str]):
+        if args:
+            raise NotImplementedError('the browsers run the benchmarks with the default shape')
         output_text = self._run_and_get_output(f'{task}/bench-{task}_{version}.html')
-        return self._parse_running_time(output_text)
+        return self._parse_benchmark(output_text)
+
+    def _do_roofline(self) -> str:
+        return self._run_and_get_output('misc/roofline.html')
 
     def _do_close(self):
         self.driver.close()
@@ -216,13 +249,13 @@ class WAVM(WASIBase):
         except subprocess.CalledProcessError:
             return False
 
-    def _do_benchmark(self, task: str, version: str) -> float:
+    def _do_benchmark(self, task: str, version: str, args: List[str]) -> dict:
         output = subprocess.check_output(
             [self.wavm_exe, 'run', '--enable', 'all',
-                f'./{task}/bench-{task}_{version}'],
+                f'./{task}/bench-{task}_{version}'] + args,
             cwd=self.build_dir)
         output = output.decode()
-        return self._parse_running_time(output)
+        return self._parse_benchmark(output)
 
 
 class Wasmer(WASIBase):
@@ -237,13 +270,13 @@ class Wasmer(WASIBase):
         except subprocess.CalledProcessError:
             return False
 
-    def _do_benchmark(self, task: str, version: str) -> float:
+    def _do_benchmark(self, task: str, version: str, args: List[str]) -> dict:
         output = subprocess.check_output(
             ['wasmer', 'run', '--enable-all', '--llvm',
-                f'./{task}/bench-{task}_{version}'],
+                f'./{task}/bench-{task}_{version}'] + args,
             cwd=self.build_dir)
         output = output.decode()
-        return self._parse_running_time(output)
+        return self._parse_benchmark(output)
 
 
 class Wasmtime(WASIBase):
@@ -268,13 +301,13 @@ class Wasmtime(WASIBase):
         except subprocess.CalledProcessError:
             return False
 
-    def _do_benchmark(self, task: str, version: str) -> float:
+    def _do_benchmark(self, task: str, version: str, args: List[str]) -> dict:
         output = subprocess.check_output(
             [f'{self.wasmtime_exe}', 'run', '--enable-all', '--cranelift',
-                f'./{task}/bench-{task}_{version}'],
+                f'./{task}/bench-{task}_{version}'] + args,
             cwd=self.build_dir)
         output = output.decode()
-        return self._parse_running_time(output)
+        return self._parse_benchmark(output)
 
 
 def main(argv):
@@ -291,10 +324,15 @@ def main(argv):
     parser = argparse.ArgumentParser()
     for task in tasks:
         parser.add_argument(f'--{task}', type=str, nargs='+')
+        # the arguments of the benchmarks, the shape, instead of their default
+        parser.add_argument(f'--{task}-shape', type=int, nargs=3)
 
     parser.add_argument('--platforms', type=str, nargs='+')
-    parser.add_argument('--n-repeat', type=int, nargs='?', default=3)
+    # every run repeats the kernel in the process, see util/bench.hpp
+    parser.add_argument('--n-repeat', type=int, nargs='?', default=1)
     parser.add_argument('--skip-tests', action='store_true')
+    # the share of the roofline of the platform that each run attains, see misc/roofline.cpp
+    parser.add_argument('--roofline', action='store_true')
 
     args = parser.parse_args()
 
@@ -303,12 +341,34 @@ def main(argv):
     report_file_path = f'reports/report-{datetime.now().strftime("%Y-%m-%d-%H-%M-%S")}.csv'
     csv_file = open(report_file_path, 'w')
     results_csv = csv.writer(csv_file)
-    results_csv.writerow(['platform', 'task', 'version', 'running-time'])
+    stat_fields = ['median', 'min', 'p90', 'samples', 'gflops', 'gbytes', 'intensity']
+    roof_fields = ['roof-1t', 'roof-all']
+    results_csv.writerow(
+        ['platform', 'task', 'version', 'running-time'] + stat_fields[1:] + roof_fields)
+
+    # percent of the attainable rate min(peak, intensity * bandwidth) that a run reaches, with
+    # the roofs of 1 thread and of all the threads
+    def roof_percents(run, roofs):
+        if not roofs or not run.get('gflops') or not run.get('gbytes'):
+            return ['', '']
+        intensity = run.get('intensity', run['gflops'] / run['gbytes'])
+        return [100 * run['gflops'] / min(peak, intensity * bandwidth)
+                for peak, bandwidth in zip(roofs['gflops'], roofs['gbytes'])]
 
     for platform_name in args.platforms:
         platform = platforms[platform_name](
             f'build-{platform_name}', platform_name)
 
+        roofs = None
+        if args.roofline:
+            try:
+                roofs = platform.roofline()
+            except Exception as e:
+                print(f'Error while measuring the roofline: {e}')
+            else:
+                print(f'Roofline: {roofs["gflops"]} GFLOP/s, {roofs["gbytes"]} GB/s '
+                      '(1 thread, all threads)')
+
         for task in tasks:
             requested_versions = getattr(args, task)
             if not requested_versions:
@@ -316,31 +376,44 @@ def main(argv):
 
             for version in requested_versions:
                 try:
-                    running_times = platform.benchmark(
-                        task, version, n_repeat=args.n_repeat, skip_tests=args.skip_tests)
+                    runs = platform.benchmark(
+                        task, version, n_repeat=args.n_repeat, skip_tests=args.skip_tests,
+                        shape=getattr(args, f'{task}_shape'))
                 except Exception as e:
                     print(f'Error while processing {task}_{version}: {e}')
                 else:
-                    for rt in running_times:
+                    for run in runs:
                         results_csv.writerow(
-                            [platform_name, task, version, rt])
+                            [platform_name, task, version] + [run.get(f, '') for f in stat_fields]
+                            + roof_percents(run, roofs))
                     results.append(
-                        [platform_name, task, version, running_times])
+                        [platform_name, task, version, runs, roofs])
 
         platform.close()
 
     csv_file.close()
 
-    def stat(a):
+    def stat(runs):
+        if len(runs) == 1:
+            r = runs[0]
+            return f'{r["median"]:.6f} (min {r["min"]:.6f}, p90 {r["p90"]:.6f})'
+
+        a = [r['median'] for r in runs]
         average = sum(a) / len(a)
         var = 0
         for x in a:
             var += (x-average)**2 / len(a)
         std = var ** 0.5
-        return f'{average:.3f} ± {std:.3f}'
+        return f'{average:.6f} ± {std:.6f}'
+
+    def roof(runs, roofs):
+        percents = roof_percents(runs[0], roofs)
+        if percents[0] == '':
+            return ''
+        return f'\t{percents[0]:.1f}% of 1-thread roof, {percents[1]:.1f}% of all-thread roof'
 
-    print('\n'.join(['\t'.join(str(e) for e in row[:-1]) +
-                     '\t' + stat(row[-1]) for row in results]))
+    print('\n'.join(['\t'.join(str(e) for e in row[:-2]) +
+                     '\t' + stat(row[-2]) + roof(row[-2], row[-1]) for row in results]))
 
 
 if __name__ == '__main__':
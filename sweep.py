@@ -0,0 +1,255 @@
+import sys
+import subprocess
+import os
+import argparse
+import re
+import csv
+import json
+from datetime import datetime
+from typing import List
+
+
+# a grid is a list of (row, column, shape): the cell of the heatmap a shape goes to, and the
+# arguments of bench-mm (n1 n2 n3) or bench-conv (n1 n2 nw) for it.
+# the names of the row and the column are the first cell of the csv.
+
+def _pow2(lo: int, hi: int) -> List[int]:
+    return [1 << k for k in range(lo, hi + 1)]
+
+
+# sizes a little off the multiples of the vectors and the micro-tiles, and the multiple itself
+OFFSETS = [-1, 0, 1, 3, 5, 7]
+
+MM_GRIDS = {
+    # square mat1 (n1 = n2) by n3, all powers of two, the leading dimensions too
+    'pow2': ('n1=n2 \\ n3', [(n, m, (n, n, m)) for n in _pow2(4, 11) for m in _pow2(4, 11)]),
+    # cubes of 2^k + offset
+    'offbyone': ('2^k \\ offset',
+                 [(b, o, (b + o, b + o, b + o)) for b in _pow2(5, 10) for o in OFFSETS]),
+    # many rows, few columns, and the transpose
+    'tall': ('n1 \\ n3 (n2=256)',
+             [(n, m, (n, 256, m)) for n in _pow2(10, 13) for m in _pow2(0, 6)]),
+    'wide': ('n1 \\ n3 (n2=256)',
+             [(n, m, (n, 256, m)) for n in _pow2(0, 6) for m in _pow2(10, 13)]),
+    # a matrix times a vector, and a vector times a matrix
+    'gemv': ('n \\ operands',
+             [(n, c, s) for n in _pow2(6, 12) + [1000, 1001, 4095]
+              for c, s in [('mat*vec', (n, n, 1)), ('vec*mat', (1, n, n))]]),
+}
+
+CONV_GRIDS = {
+    # every odd window from 1 to 63
+    'window': ('n1=n2 \\ nw', [(n, w, (n, n, w)) for n in [256, 512, 1024]
+                               for w in range(1, 64, 2)]),
+    'pow2': ('n1 \\ n2 (nw=5)', [(n, m, (n, m, 5)) for n in _pow2(6, 12) for m in _pow2(6, 12)]),
+    'offbyone': ('2^k \\ offset (nw=7)',
+                 [(b, o, (b + o, b + o, 7)) for b in _pow2(6, 11) for o in OFFSETS]),
+    'tall': ('n1 \\ n2 (nw=7)', [(n, m, (n, m, 7)) for n in _pow2(10, 14) for m in _pow2(0, 6)]),
+    'wide': ('n1 \\ n2 (nw=7)', [(n, m, (n, m, 7)) for n in _pow2(0, 6) for m in _pow2(10, 14)]),
+}
+
+GRIDS = {'mm': MM_GRIDS, 'conv': CONV_GRIDS}
+
+# the kernel that the results of the others are compared with, one that is fast at every shape
+REFERENCES = {'mm': 'mm_simd2_mt', 'conv': 'conv_simd_mt'}
+
+# left out unless named with --kernels, the naive loops take hours at the large shapes
+SLOW = {'mm': ['mm_base'], 'conv': ['conv_base']}
+
+
+def custom_grid(dims: List[str]):
+    # the product of comma separated lists of the three sizes. the rows of the heatmap are the
+    # first size with several values, the columns the second one.
+    values = [[int(v) for v in d.split(',')] for d in dims]
+    varying = [i for i, v in enumerate(values) if len(v) > 1] + [None, None]
+    r, c = varying[0], varying[1]
+
+    shapes = [(a, b, d) for a in values[0] for b in values[1] for d in values[2]]
+    name = f'{"size " + str(r + 1) if r is not None else ""} \\ ' \
+           f'{"size " + str(c + 1) if c is not None else ""}'
+    return (name, [(s[r] if r is not None else '', s[c] if c is not None else '', s)
+                   for s in shapes])
+
+
+def configure(build_dir: str):
+    os.makedirs(build_dir, exist_ok=True)
+    subprocess.check_call([
+        'cmake',
+        os.getcwd(),
+        '-DCMAKE_BUILD_TYPE=Release',
+        '-DCMAKE_CXX_FLAGS=-march=native',
+    ], cwd=build_dir, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+def build(build_dir: str, task: str):
+    print(f'Building bench-{task} ...')
+    subprocess.check_call([
+        'cmake',
+        '--build', '.',
+        '--target', f'bench-{task}',
+        '--parallel', '2',
+    ], cwd=build_dir, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+# the statistics of each kernel in the output of the driver, by name, with the max error
+def parse_driver(output: str) -> dict:
+    runs = {}
+    error = None
+    for line in output.split('\n'):
+        m = re.match(r'^max error:\s+(\S+)', line)
+        if m:
+            error = float(m.group(1))
+        m = re.match(r'^json:\s+(\{.*\})', line)
+        if m:
+            run = json.loads(m.group(1))
+            run['error'] = error if error is not None else 0.0
+            runs[run['kernel']] = run
+            error = None
+    return runs
+
+
+# the kernels registered in the driver, without the ones the cpu cannot run
+def list_kernels(build_dir: str, task: str) -> List[str]:
+    output = subprocess.check_output([f'./{task}/bench-{task}', '--list'], cwd=build_dir)
+    names = [line.split('\t')[0] for line in output.decode().split('\n') if line]
+
+    # the driver refuses the ones the cpu cannot run, a call at the smallest shape tells
+    env = dict(os.environ, CMPE492_BENCH_WARMUP='0', CMPE492_BENCH_MIN_TIME='0')
+    kernels = []
+    for k in names:
+        try:
+            subprocess.check_output([f'./{task}/bench-{task}', '--kernels', k, '1', '1', '1'],
+                                    cwd=build_dir, env=env)
+        except subprocess.CalledProcessError:
+            continue
+        kernels.append(k)
+    return kernels
+
+
+# each kernel runs in a process of its own with the reference, so that one that is slow or crashes
+# at a shape fails its own cell only
+def sweep(build_dir: str, task: str, grid, kernels: List[str], reference: str,
+          timeout: float) -> List[tuple]:
+    results = []
+    _, cells = grid
+
+    for i, (row, col, shape) in enumerate(cells):
+        print(f'[{i + 1}/{len(cells)}] {task} {" ".join(str(n) for n in shape)}', flush=True)
+
+        runs = {}
+        for k in kernels:
+            cmd = [f'./{task}/bench-{task}', '--kernels', k if k == reference else
+                   f'{reference},{k}'] + [str(n) for n in shape]
+            try:
+                output = subprocess.check_output(cmd, cwd=build_dir, timeout=timeout).decode()
+                run = parse_driver(output).get(k)
+                if run is not None:
+                    runs[k] = run
+            except (subprocess.CalledProcessError, subprocess.TimeoutExpired) as e:
+                print(f'Error of {k} at {shape}: {e}')
+
+        results.append((row, col, shape, runs))
+
+    return results
+
+
+def write_heatmaps(out_dir: str, task: str, grid_name: str, grid, results, kernels: List[str],
+                   metric: str, max_error: float):
+    axes, _ = grid
+    rows = list(dict.fromkeys(r for r, _, _, _ in results))
+    cols = list(dict.fromkeys(c for _, c, _, _ in results))
+
+    # all the statistics, a line per kernel and shape
+    with open(os.path.join(out_dir, f'{task}-{grid_name}.csv'), 'w') as f:
+        out = csv.writer(f)
+        fields = ['median', 'min', 'p90', 'samples', 'gflops', 'gbytes', 'intensity', 'error']
+        out.writerow(['kernel', 'shape'] + fields)
+        for _, _, shape, runs in results:
+            for k in kernels:
+                run = runs.get(k, {})
+                out.writerow([k, 'x'.join(str(n) for n in shape)] +
+                             [run.get(field, '') for field in fields])
+
+    # the heatmap of each kernel, "fail" where the run failed or its result differs from the
+    # one of the reference by more than max_error
+    for k in kernels:
+        cells = {}
+        for r, c, _, runs in results:
+            run = runs.get(k)
+            if run is None:
+                cells[r, c] = 'fail'
+            elif run['error'] > max_error or run['error'] != run['error']:
+                cells[r, c] = 'fail'
+            else:
+                cells[r, c] = f'{run[metric]:.6g}'
+
+        with open(os.path.join(out_dir, f'{task}-{grid_name}-{k}.csv'), 'w') as f:
+            out = csv.writer(f)
+            out.writerow([axes] + cols)
+            for r in rows:
+                out.writerow([r] + [cells.get((r, c), '') for c in cols])
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(
+        description='sweep the kernels of bench-mm or bench-conv over grids of shapes, and '
+                    'write a csv heatmap per kernel and grid')
+    parser.add_argument('--task', choices=['mm', 'conv'], required=True)
+    parser.add_argument('--grids', type=str, nargs='+', default=['all'],
+                        help='the grids to sweep, "all" for every one of the task: '
+                             f'mm: {", ".join(MM_GRIDS)}; conv: {", ".join(CONV_GRIDS)}')
+    parser.add_argument('--custom', type=str, nargs=3, metavar='SIZES',
+                        help='a grid of the given sizes, comma separated lists of n1, n2 and '
+                             'n3 (or nw), instead of --grids')
+    parser.add_argument('--kernels', type=str, nargs='+',
+                        help='the kernels of the driver to run, by default all that the cpu can '
+                             f'but {", ".join(k for ks in SLOW.values() for k in ks)}')
+    parser.add_argument('--reference', type=str,
+                        help='the kernel whose results the others are compared with, '
+                             f'{" or ".join(REFERENCES.values())} by default')
+    parser.add_argument('--metric', type=str, default='gflops',
+                        help='the statistic in the heatmaps, gflops, median, min, p90 ...')
+    # float results of different kernels differ in their last bits, more is wrong
+    parser.add_argument('--max-error', type=float, default=1e-4)
+    parser.add_argument('--min-time', type=str, default='0.1',
+                        help='seconds of samples per kernel and shape, sets CMPE492_BENCH_MIN_TIME')
+    parser.add_argument('--timeout', type=float, default=600,
+                        help='seconds a kernel may take at a shape, with the reference')
+    parser.add_argument('--build-dir', type=str, default='build-native')
+
+    args = parser.parse_args()
+
+    if args.custom:
+        grids = {'custom': custom_grid(args.custom)}
+    elif 'all' in args.grids:
+        grids = GRIDS[args.task]
+    else:
+        unknown = [g for g in args.grids if g not in GRIDS[args.task]]
+        if unknown:
+            parser.error(f'unknown grids for {args.task}: {", ".join(unknown)}')
+        grids = {g: GRIDS[args.task][g] for g in args.grids}
+
+    # the flag wins over a value inherited from the environment
+    os.environ['CMPE492_BENCH_MIN_TIME'] = args.min_time
+
+    configure(args.build_dir)
+    build(args.build_dir, args.task)
+
+    out_dir = f'reports/sweep-{datetime.now().strftime("%Y-%m-%d-%H-%M-%S")}'
+    os.makedirs(out_dir, exist_ok=True)
+
+    reference = args.reference or REFERENCES[args.task]
+    kernels = args.kernels or [k for k in list_kernels(args.build_dir, args.task)
+                               if k not in SLOW[args.task]]
+
+    for name, grid in grids.items():
+        print(f'Sweeping {args.task} over the grid "{name}" ...')
+        results = sweep(args.build_dir, args.task, grid, kernels, reference, args.timeout)
+        write_heatmaps(out_dir, args.task, name, grid, results, kernels, args.metric,
+                       args.max_error)
+
+    print(f'Heatmaps written to {out_dir}')
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "perf_counters.hpp"
+
+namespace cmpe492 {
+
+/// how bench_run() measures a function. the defaults can be changed with the environment
+/// variables CMPE492_BENCH_WARMUP and CMPE492_BENCH_MIN_TIME.
+struct bench_options
+{
+    int warmup = 1;           // untimed calls before the measurement, the first one is cold
+    double min_time = 0.5;    // seconds of timed calls to aim for
+    double min_sample = 1e-4; // shortest sample, faster functions are called several times a sample
+    int min_samples = 3;
+    int max_samples = 1000;
+
+    /// the defaults, with the values of the environment variables that are set
+    static bench_options from_env()
+    {
+        bench_options opt;
+
+        if (char const* env = std::getenv("CMPE492_BENCH_WARMUP")) {
+            opt.warmup = std::max(0, std::atoi(env));
+        }
+        if (char const* env = std::getenv("CMPE492_BENCH_MIN_TIME")) {
+            opt.min_time = std::max(0.0, std::atof(env));
+        }
+
+        return opt;
+    }
+};
+
+/// running times of a function per call, in seconds
+struct bench_stats
+{
+    int samples = 0; // timed samples
+    int batch = 1;   // calls per sample
+    double min = 0, median = 0, p90 = 0, mean = 0;
+
+    perf_counts counts; // of all the timed calls, if bench_run() had counters
+};
+
+/// time each of funcs like bench_run(), in rounds that take a sample of every function in turn,
+/// so that changes of the state of the machine during the measurement (clock frequency, other
+/// load) affect them alike. every function gets the same number of samples, as many as the
+/// slowest needs, and its own calls per sample.
+/// counters, if not empty, has the counters of each function, which count its timed calls.
+inline std::vector<bench_stats>
+bench_run_interleaved(std::vector<std::function<void()>> const& funcs,
+                      bench_options const& opt = bench_options::from_env(),
+                      std::vector<perf_counters*> const& counters = {})
+{
+    using clock = std::chrono::steady_clock;
+
+    auto seconds = [](clock::duration d) { return std::chrono::duration<double>(d).count(); };
+
+    const int n_funcs = static_cast<int>(funcs.size());
+    std::vector<bench_stats> st(n_funcs);
+
+    // the calls per sample of each function, from the time of its last warmup call
+    double slowest = 0;
+    for (int f = 0; f < n_funcs; f++) {
+        double estimate = 0;
+        for (int i = 0; i < opt.warmup; i++) {
+            const auto start = clock::now();
+            funcs[f]();
+            estimate = seconds(clock::now() - start);
+        }
+        if (opt.warmup == 0) {
+            // the first sample is timed anyway, it cannot be longer than needed
+            estimate = opt.min_time;
+        }
+
+        st[f].batch =
+          std::max(1, static_cast<int>(std::ceil(opt.min_sample / std::max(estimate, 1e-9))));
+        slowest = std::max(slowest, estimate * st[f].batch);
+    }
+
+    const int n_samples =
+      std::clamp(static_cast<int>(std::ceil(opt.min_time / std::max(slowest, 1e-9))),
+                 opt.min_samples,
+                 opt.max_samples);
+
+    for (auto* c : counters) {
+        c->reset();
+    }
+
+    std::vector<std::vector<double>> times(n_funcs, std::vector<double>(n_samples));
+    for (int s = 0; s < n_samples; s++) {
+        for (int f = 0; f < n_funcs; f++) {
+            if (!counters.empty()) {
+                counters[f]->start();
+            }
+
+            const auto start = clock::now();
+            for (int i = 0; i < st[f].batch; i++) {
+                funcs[f]();
+            }
+            times[f][s] = seconds(clock::now() - start) / st[f].batch;
+
+            if (!counters.empty()) {
+                counters[f]->stop();
+            }
+        }
+    }
+
+    for (int f = 0; f < n_funcs; f++) {
+        auto& t = times[f];
+        std::sort(t.begin(), t.end());
+
+        const int n = n_samples;
+        st[f].samples = n;
+        st[f].min = t[0];
+        st[f].median = (n % 2) ? t[n / 2] : (t[n / 2 - 1] + t[n / 2]) / 2;
+        st[f].p90 = t[std::max(0, static_cast<int>(std::ceil(0.9 * n)) - 1)];
+
+        for (double x : t) {
+            st[f].mean += x / n;
+        }
+
+        if (!counters.empty()) {
+            st[f].counts = counters[f]->read();
+        }
+    }
+
+    return st;
+}
+
+/// time func(). after the warmup calls, the time of the last one sets the calls per sample and
+/// the number of samples, so that the samples take about opt.min_time together.
+/// the counters, if given, count the timed calls.
+template<typename Func>
+bench_stats
+bench_run(Func&& func,
+          bench_options const& opt = bench_options::from_env(),
+          perf_counters* counters = nullptr)
+{
+    std::vector<perf_counters*> c;
+    if (counters) {
+        c.push_back(counters);
+    }
+
+    return bench_run_interleaved({ [&func] { func(); } }, opt, c)[0];
+}
+
+/// print the statistics of bench_run() for a function that does flops floating point operations
+/// and moves bytes bytes from and to memory per call (the least it has to, which puts a bound on
+/// its speed). the median is printed as the running time, followed by the other statistics,
+/// the rates at the median and the arithmetic intensity flops / bytes, and all of these as a line
+/// of json after "json:", with task and shape to tell the runs apart.
+/// with the counters of bench_run(), the events per call and the metrics derived from them
+/// follow the rates, the events that could not be counted are left out.
+/// the name of the kernel, if given, is added to the json, for the drivers that run several.
+inline void
+bench_report(std::ostream& os,
+             std::string const& task,
+             std::vector<long> const& shape,
+             bench_stats const& st,
+             double flops,
+             double bytes,
+             perf_counters const* counters = nullptr,
+             std::string const& kernel = {})
+{
+    const double gflops = flops / st.median * 1e-9;
+    const double gbytes = bytes / st.median * 1e-9;
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(6);
+
+    out << "running time:\t" << st.median << " s\n";
+    out << "min:\t" << st.min << " s\n";
+    out << "p90:\t" << st.p90 << " s\n";
+    out << "samples:\t" << st.samples << " x " << st.batch << " calls\n";
+
+    out << std::setprecision(3);
+    out << "GFLOP/s:\t" << gflops << "\n";
+    out << "GB/s:\t" << gbytes << "\n";
+    out << "intensity:\t" << flops / bytes << " FLOP/byte\n";
+
+    // events per call, and the metrics that can be derived from them
+    perf_counts per_call;
+    std::vector<std::pair<char const*, double>> derived;
+
+    if (counters) {
+        const double calls = double(st.samples) * st.batch;
+
+        for (int e = 0; e < n_perf_events; e++) {
+            if (st.counts.values[e] >= 0) {
+                per_call.values[e] = st.counts.values[e] / calls;
+            }
+        }
+
+        auto ratio = [&](char const* name, double num, double den, double scale) {
+            if (num >= 0 && den > 0) {
+                derived.emplace_back(name, num / den * scale);
+            }
+        };
+
+        ratio("IPC", per_call[perf_event::instructions], per_call[perf_event::cycles], 1);
+        ratio("FLOP/cycle", flops, per_call[perf_event::cycles], 1);
+        ratio("FP ops/FLOP", per_call[perf_event::fp_ops], flops, 1);
+        ratio("L1D misses/kFLOP", per_call[perf_event::l1d_misses], flops, 1e3);
+        ratio("LLC misses/MFLOP", per_call[perf_event::llc_misses], flops, 1e6);
+        ratio("dTLB misses/MFLOP", per_call[perf_event::dtlb_misses], flops, 1e6);
+
+        for (int e = 0; e < n_perf_events; e++) {
+            if (per_call.values[e] >= 0) {
+                out << perf_event_name(static_cast<perf_event>(e)) << ":\t" << per_call.values[e]
+                    << " per call\n";
+            }
+        }
+        for (auto const& [name, value] : derived) {
+            out << name << ":\t" << value << "\n";
+        }
+        if (!counters->error().empty()) {
+            out << "counters not available:\t" << counters->error() << "\n";
+        }
+    }
+
+    out << std::setprecision(9) << std::defaultfloat;
+    out << "json:\t{\"task\": \"" << task << "\", ";
+    if (!kernel.empty()) {
+        out << "\"kernel\": \"" << kernel << "\", ";
+    }
+    out << "\"shape\": [";
+    for (size_t i = 0; i < shape.size(); i++) {
+        out << (i ? ", " : "") << shape[i];
+    }
+    out << "], \"samples\": " << st.samples << ", \"batch\": " << st.batch
+        << ", \"min\": " << st.min << ", \"median\": " << st.median << ", \"p90\": " << st.p90
+        << ", \"mean\": " << st.mean << ", \"gflops\": " << gflops << ", \"gbytes\": " << gbytes
+        << ", \"intensity\": " << flops / bytes;
+
+    if (counters) {
+        out << ", \"counters\": {";
+        bool first = true;
+        for (int e = 0; e < n_perf_events; e++) {
+            if (per_call.values[e] >= 0) {
+                out << (first ? "" : ", ") << "\"" << perf_event_name(static_cast<perf_event>(e))
+                    << "\": " << per_call.values[e];
+                first = false;
+            }
+        }
+        for (auto const& [name, value] : derived) {
+            out << (first ? "" : ", ") << "\"" << name << "\": " << value;
+            first = false;
+        }
+        out << "}";
+    }
+
+    out << "}\n";
+
+    os << out.str() << std::flush;
+}
+
+/// print on one line after label the statistics of a function that the one of st is compared
+/// with, and the speedup of the latter at the median. printed before the bench_report() of st, so
+/// that the json line, which report.py reads, is the one of the compared function.
+inline void
+bench_report_baseline(std::ostream& os,
+                      std::string const& label,
+                      bench_stats const& baseline,
+                      bench_stats const& st)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(6);
+
+    out << label << ":\t" << baseline.median << " s (min " << baseline.min << " s, p90 "
+        << baseline.p90 << " s)";
+    out << std::setprecision(2) << "\tspeedup " << baseline.median / st.median << "x\n";
+
+    os << out.str() << std::flush;
+}
+
+} // namespace cmpe492
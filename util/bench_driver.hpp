@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "perf_counters.hpp"
+#include "registry.hpp"
+
+namespace cmpe492 {
+
+/// main() of a driver that runs the variants of a task registered with registry.hpp in turn on
+/// the same operands (bench-mm and bench-conv), comparing each result with the one of the first
+/// variant. Task describes the task:
+///
+///     using fn = ...;                           // the type of its kernels
+///     static constexpr char const* name;        // "mm", also the prefix of the kernel names
+///     static constexpr char const* shape_names; // "n1 n2 n3", for the usage
+///     static constexpr std::array<int, 3> default_shape;
+///     static double flops(shape), bytes(shape); // the work of a call, for bench_report()
+///     struct operands                           // random operands of a shape, and the result
+///     {
+///         explicit operands(shape);
+///         void call(fn* kernel);                // writes res
+///         std::vector<float> res;
+///     };
+///
+/// the arguments are --list, which prints the registered kernels, --kernels name,... and the
+/// shape, the default one if not given.
+template<typename Task>
+int
+bench_driver(int argc, char* argv[])
+{
+    using shape_t = std::array<int, 3>;
+    using task_registry = registry<typename Task::fn>;
+
+    std::string list;
+    std::vector<int> args;
+
+    for (int a = 1; a < argc; a++) {
+        if (std::strcmp(argv[a], "--list") == 0) {
+            for (auto const& e : task_registry::instance().entries()) {
+                std::cout << e.name << "\t" << isa_name(e.required) << "\n";
+            }
+            return 0;
+        } else if (std::strcmp(argv[a], "--kernels") == 0 && a + 1 < argc) {
+            list = argv[++a];
+        } else {
+            args.push_back(std::atoi(argv[a]));
+        }
+    }
+
+    shape_t shape = Task::default_shape;
+    if (args.size() == shape.size()) {
+        std::copy(args.begin(), args.end(), shape.begin());
+    } else if (!args.empty()) {
+        std::cout << "usage: " << argv[0] << " [--list] [--kernels name,...] [" << Task::shape_names
+                  << "]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string error;
+    const std::string prefix = std::string(Task::name) + "_";
+    const auto kernels = task_registry::instance().select(list, prefix, error);
+    if (kernels.empty()) {
+        std::cout << (error.empty() ? "no kernels" : error) << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << shape[0] << " " << shape[1] << " " << shape[2] << std::endl;
+
+    typename Task::operands ops(shape);
+    auto& res = ops.res;
+
+    // opened before the first call, which starts the thread pool, so that its workers are counted
+    std::vector<std::unique_ptr<perf_counters>> counters;
+    std::vector<perf_counters*> counter_ptrs;
+    std::vector<std::function<void()>> funcs;
+
+    for (auto const* k : kernels) {
+        counters.push_back(std::make_unique<perf_counters>());
+        counter_ptrs.push_back(counters.back().get());
+        funcs.push_back([&ops, k] { ops.call(k->kernel); });
+    }
+
+    const auto st = bench_run_interleaved(funcs, bench_options::from_env(), counter_ptrs);
+
+    // the largest difference from the result of the first kernel, relative to its largest element
+    std::vector<float> ref;
+    for (size_t k = 0; k < kernels.size(); k++) {
+        std::fill(res.begin(), res.end(), 0.0f);
+        funcs[k]();
+
+        std::cout << "kernel:\t" << kernels[k]->name << "\n";
+
+        if (k == 0) {
+            ref = res;
+        } else {
+            float diff = 0, scale = 0;
+            for (size_t i = 0; i < res.size(); i++) {
+                const float d = std::abs(res[i] - ref[i]);
+                diff = std::isnan(d) ? d : std::max(diff, d);
+                scale = std::max(scale, std::abs(ref[i]));
+            }
+            std::cout << "max error:\t" << diff / std::max(scale, 1e-30f) << " (relative to "
+                      << kernels[0]->name << ")\n";
+        }
+
+        bench_report(std::cout,
+                     Task::name,
+                     { shape[0], shape[1], shape[2] },
+                     st[k],
+                     Task::flops(shape),
+                     Task::bytes(shape),
+                     counters[k].get(),
+                     kernels[k]->name);
+    }
+
+    std::cout << "========" << std::endl;
+
+    return 0;
+}
+
+} // namespace cmpe492
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+namespace cmpe492 {
+
+/// instruction sets that the kernels are built for, in increasing order of capability
+enum class isa
+{
+    sse,
+    avx2,
+    avx512
+};
+
+/// name of the instruction set, also the value accepted by the CMPE492_ISA environment variable
+inline char const*
+isa_name(isa x)
+{
+    switch (x) {
+        case isa::avx512:
+            return "avx512";
+        case isa::avx2:
+            return "avx2";
+        default:
+            return "sse";
+    }
+}
+
+/// the most capable instruction set supported by the cpu, found with cpuid
+inline isa
+detect_isa()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return isa::avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return isa::avx2;
+    }
+#endif
+    return isa::sse;
+}
+
+/// the instruction set the kernels should use.
+/// the CMPE492_ISA environment variable (sse, avx2 or avx512) can select a less capable one
+/// than detected, asking for one that the cpu does not support has no effect.
+inline isa
+select_isa()
+{
+    const isa detected = detect_isa();
+
+    if (char const* env = std::getenv("CMPE492_ISA")) {
+        for (isa x : { isa::sse, isa::avx2, isa::avx512 }) {
+            if (std::strcmp(env, isa_name(x)) == 0 && x <= detected) {
+                return x;
+            }
+        }
+    }
+
+    return detected;
+}
+
+} // namespace cmpe492
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define CMPE492_HAVE_PERF_EVENTS 1
+#endif
+
+namespace cmpe492 {
+
+/// the events counted by perf_counters
+enum class perf_event
+{
+    cycles,
+    instructions,
+    l1d_misses,  // l1 data cache read misses
+    llc_misses,  // last level cache misses
+    dtlb_misses, // data tlb read misses
+    fp_ops,      // floating point operations retired, an fma counts as 2, intel only
+    page_faults, // a software event, counted in virtual machines too
+    count
+};
+
+constexpr int n_perf_events = static_cast<int>(perf_event::count);
+
+/// name of an event for reports
+inline char const*
+perf_event_name(perf_event e)
+{
+    static char const* const names[n_perf_events] = {
+        "cycles",      "instructions", "L1D misses",  "LLC misses",
+        "dTLB misses", "FP ops",       "page faults",
+    };
+    return names[static_cast<int>(e)];
+}
+
+/// the counts of the events in a region, -1 for the events that could not be counted
+struct perf_counts
+{
+    std::array<double, n_perf_events> values;
+
+    perf_counts() { values.fill(-1); }
+
+    bool has(perf_event e) const { return values[static_cast<int>(e)] >= 0; }
+    double operator[](perf_event e) const { return values[static_cast<int>(e)]; }
+    double& operator[](perf_event e) { return values[static_cast<int>(e)]; }
+};
+
+/// hardware performance counters read with perf_event_open, around the regions between start()
+/// and stop(), accumulated.
+///
+/// the calling thread is counted, and the threads it creates after the counters, so the counters
+/// must exist before the thread pool starts (the first parallel_for) to count its workers.
+/// the events that cannot be opened, because the kernel does not permit it
+/// (/proc/sys/kernel/perf_event_paranoid), the cpu has no such event or it is not linux, are
+/// skipped and reported as not available. when there are more events than hardware counters,
+/// the kernel multiplexes them and the counts are scaled to the whole region.
+class perf_counters
+{
+#ifdef CMPE492_HAVE_PERF_EVENTS
+    // fp_ops is the sum of several raw intel events, weighted by the floats per instruction
+    struct source
+    {
+        perf_event event;
+        uint32_t type;
+        uint64_t config;
+        double weight;
+    };
+
+    // the config of a PERF_TYPE_HW_CACHE event: cache, operation << 8 and result << 16
+    static constexpr uint64_t l1d_read_miss =
+      PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    static constexpr uint64_t dtlb_read_miss =
+      PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+    // FP_ARITH_INST_RETIRED (event 0xc7) of skylake and later: scalar, 128, 256 and 512 bit
+    // single precision
+    static constexpr int n_sources = 10;
+    static constexpr source sources[n_sources] = {
+        { perf_event::cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 1 },
+        { perf_event::instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, 1 },
+        { perf_event::l1d_misses, PERF_TYPE_HW_CACHE, l1d_read_miss, 1 },
+        { perf_event::llc_misses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, 1 },
+        { perf_event::dtlb_misses, PERF_TYPE_HW_CACHE, dtlb_read_miss, 1 },
+        { perf_event::fp_ops, PERF_TYPE_RAW, 0x02c7, 1 },
+        { perf_event::fp_ops, PERF_TYPE_RAW, 0x08c7, 4 },
+        { perf_event::fp_ops, PERF_TYPE_RAW, 0x20c7, 8 },
+        { perf_event::fp_ops, PERF_TYPE_RAW, 0x80c7, 16 },
+        { perf_event::page_faults, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, 1 },
+    };
+
+    std::array<int, n_sources> fds_;
+#endif
+
+    std::string error_; // why the first event that failed could not be opened
+
+public:
+    perf_counters()
+    {
+#ifdef CMPE492_HAVE_PERF_EVENTS
+        // the raw events are only known for intel
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        const bool intel = __builtin_cpu_is("intel");
+#else
+        const bool intel = false;
+#endif
+
+        for (int i = 0; i < n_sources; i++) {
+            fds_[i] = -1;
+
+            if (sources[i].type == PERF_TYPE_RAW && !intel) {
+                continue;
+            }
+
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = sources[i].type;
+            attr.config = sources[i].config;
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+
+            if (fds_[i] < 0 && error_.empty()) {
+                error_ = std::string(perf_event_name(sources[i].event)) + ": " +
+                         std::strerror(errno);
+            }
+        }
+#else
+        error_ = "not supported on this platform";
+#endif
+    }
+
+    ~perf_counters()
+    {
+#ifdef CMPE492_HAVE_PERF_EVENTS
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    perf_counters(perf_counters const&) = delete;
+    perf_counters& operator=(perf_counters const&) = delete;
+
+    /// the reason the first event that is not available could not be opened, empty if all are
+    std::string const& error() const { return error_; }
+
+    /// set the counts to 0
+    void reset()
+    {
+#ifdef CMPE492_HAVE_PERF_EVENTS
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            }
+        }
+#endif
+    }
+
+    void start()
+    {
+#ifdef CMPE492_HAVE_PERF_EVENTS
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void stop()
+    {
+#ifdef CMPE492_HAVE_PERF_EVENTS
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+#endif
+    }
+
+    /// the counts since the last reset()
+    perf_counts read() const
+    {
+        perf_counts counts;
+
+#ifdef CMPE492_HAVE_PERF_EVENTS
+        std::array<bool, n_perf_events> missing = {};
+
+        for (int i = 0; i < n_sources; i++) {
+            const int e = static_cast<int>(sources[i].event);
+            uint64_t buf[3]; // value, time enabled, time running
+
+            if (fds_[i] < 0 || ::read(fds_[i], buf, sizeof(buf)) != sizeof(buf)) {
+                missing[e] = true;
+                continue;
+            }
+
+            const double value = buf[2] ? double(buf[0]) * buf[1] / buf[2] : 0.0;
+            counts.values[e] = std::max(counts.values[e], 0.0) + sources[i].weight * value;
+        }
+
+        // an event made of several sources is only known if all of them are
+        for (int e = 0; e < n_perf_events; e++) {
+            if (missing[e]) {
+                counts.values[e] = -1;
+            }
+        }
+#endif
+
+        return counts;
+    }
+};
+
+} // namespace cmpe492
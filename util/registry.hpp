@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpu.hpp"
+
+namespace cmpe492 {
+
+/// the kernels of type Fn by name, for the drivers that run several variants of a task in one
+/// binary (bench-mm and bench-conv). a variant adds itself with CMPE492_REGISTER_KERNEL() when
+/// it is built for a driver.
+template<typename Fn>
+class registry
+{
+public:
+    struct entry
+    {
+        std::string name;
+        Fn* kernel;
+        isa required; // the instruction set the variant is compiled for
+    };
+
+    static registry& instance()
+    {
+        static registry r;
+        return r;
+    }
+
+    void add(char const* name, Fn* kernel, isa required)
+    {
+        entries_.push_back({ name, kernel, required });
+    }
+
+    /// in the order of registration, which is the order the variants are linked in
+    std::vector<entry> const& entries() const { return entries_; }
+
+    /// the variant with the given name, nullptr if there is none
+    entry const* find(std::string const& name) const
+    {
+        for (auto const& e : entries_) {
+            if (e.name == name) {
+                return &e;
+            }
+        }
+        return nullptr;
+    }
+
+    /// the variants named in list, separated by commas, in its order. a name can leave out the
+    /// prefix of the task, "simd2_mt" is "mm_simd2_mt" with the prefix "mm_". an empty list
+    /// selects all the variants the cpu can run. a name that is not registered, or whose
+    /// instruction set the cpu does not support, is an error, written to error.
+    std::vector<entry const*> select(std::string const& list,
+                                     std::string const& prefix,
+                                     std::string& error) const
+    {
+        std::vector<entry const*> selected;
+
+        if (list.empty()) {
+            for (auto const& e : entries_) {
+                if (e.required <= detect_isa()) {
+                    selected.push_back(&e);
+                }
+            }
+            return selected;
+        }
+
+        size_t begin = 0;
+        while (begin <= list.size()) {
+            const size_t end = std::min(list.find(',', begin), list.size());
+            const std::string name = list.substr(begin, end - begin);
+            begin = end + 1;
+
+            entry const* e = find(name);
+            if (!e) {
+                e = find(prefix + name);
+            }
+
+            if (!e) {
+                error = "no kernel named " + name;
+                return {};
+            }
+            if (e->required > detect_isa()) {
+                error = e->name + " needs " + isa_name(e->required) + ", the cpu does not have it";
+                return {};
+            }
+
+            selected.push_back(e);
+        }
+
+        return selected;
+    }
+
+private:
+    registry() = default;
+
+    std::vector<entry> entries_;
+};
+
+/// adds a kernel to the registry when constructed, see CMPE492_REGISTER_KERNEL()
+template<typename Fn>
+struct registrar
+{
+    registrar(char const* name, Fn* kernel, isa required)
+    {
+        registry<Fn>::instance().add(name, kernel, required);
+    }
+};
+
+/// the instruction set of a target of CMPE492_TARGET_BEGIN (see simd.hpp), "avx2,fma" is avx2
+constexpr isa
+target_isa(std::string_view target)
+{
+    if (target.find("avx512") != std::string_view::npos) {
+        return isa::avx512;
+    }
+    if (target.find("avx2") != std::string_view::npos) {
+        return isa::avx2;
+    }
+    return isa::sse;
+}
+
+/// the instruction set the kernels of the file that includes this one are compiled for, that of
+/// the compiler flags or of CMPE492_TARGET if it is more capable
+constexpr isa build_isa = std::max(
+#if defined(__AVX512F__)
+  isa::avx512,
+#elif defined(__AVX2__) && defined(__FMA__)
+  isa::avx2,
+#else
+  isa::sse,
+#endif
+#ifdef CMPE492_TARGET
+  target_isa(CMPE492_TARGET)
+#else
+  isa::sse
+#endif
+);
+
+} // namespace cmpe492
+
+#define CMPE492_STRINGIFY_IMPL(x) #x
+#define CMPE492_STRINGIFY(x) CMPE492_STRINGIFY_IMPL(x)
+
+/// with CMPE492_REGISTER defined, which the drivers build their variants with, add kernel to
+/// registry<fn> under the name of the namespace of the file, CMPE492_NAMESPACE. otherwise
+/// nothing. used in that namespace, after the kernel and CMPE492_TARGET_END, so that the
+/// registration, which runs before main(), is baseline code even in the variants built for other
+/// instruction sets.
+#ifdef CMPE492_REGISTER
+#define CMPE492_REGISTER_KERNEL(fn, kernel)                                                        \
+    static const ::cmpe492::registrar<fn> registered_kernel(                                       \
+      CMPE492_STRINGIFY(CMPE492_NAMESPACE), kernel, ::cmpe492::build_isa)
+#else
+#define CMPE492_REGISTER_KERNEL(fn, kernel) static_assert(true, "")
+#endif
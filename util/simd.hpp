@@ -1,23 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+/// the copies of a file built for an instruction set other than the baseline one (see
+/// add_isa_objects() in CMakeLists.txt) are compiled with the baseline flags, and only the code
+/// between CMPE492_TARGET_BEGIN and CMPE492_TARGET_END for the instruction set CMPE492_TARGET,
+/// "avx2,fma" or "avx512f". the functions defined there are in the namespace of the copy or have
+/// internal linkage, so each copy has its own. the kernels in the headers of mm/ and conv/ are in
+/// anonymous namespaces for this, every file that includes one compiles it with its own flags.
+/// the headers they use are included before CMPE492_TARGET_BEGIN, so that the inline functions
+/// and templates shared by the copies (the thread pool, the standard library) are compiled for
+/// the baseline, whichever copy the linker keeps. without CMPE492_TARGET both are empty.
+#define CMPE492_PRAGMA(...) _Pragma(#__VA_ARGS__)
+#define CMPE492_PRAGMA_EXPAND(...) CMPE492_PRAGMA(__VA_ARGS__)
+
+#if !defined(CMPE492_TARGET)
+#define CMPE492_TARGET_BEGIN
+#define CMPE492_TARGET_END
+#elif defined(__clang__)
+#define CMPE492_TARGET_BEGIN                                                                       \
+    CMPE492_PRAGMA_EXPAND(                                                                         \
+      clang attribute push(__attribute__((target(CMPE492_TARGET))), apply_to = function))
+#define CMPE492_TARGET_END CMPE492_PRAGMA(clang attribute pop)
+#else
+#define CMPE492_TARGET_BEGIN                                                                       \
+    CMPE492_PRAGMA(GCC push_options) CMPE492_PRAGMA_EXPAND(GCC target(CMPE492_TARGET))
+#define CMPE492_TARGET_END CMPE492_PRAGMA(GCC pop_options)
+#endif
+
 namespace cmpe492 {
 
 /// aligned vector types
 typedef float float4_t __attribute__((vector_size(4 * sizeof(float)), aligned(4 * sizeof(float))));
 typedef float float8_t __attribute__((vector_size(8 * sizeof(float)), aligned(8 * sizeof(float))));
+typedef float float16_t
+  __attribute__((vector_size(16 * sizeof(float)), aligned(16 * sizeof(float))));
 
 /// unaligned (only float-aligned) vector types
 typedef float float4_unalgn_t
   __attribute__((vector_size(4 * sizeof(float)), aligned(sizeof(float))));
 typedef float float8_unalgn_t
   __attribute__((vector_size(8 * sizeof(float)), aligned(sizeof(float))));
+typedef float float16_unalgn_t
+  __attribute__((vector_size(16 * sizeof(float)), aligned(sizeof(float))));
 
 // make sure everything is sized and aligned as expected
 static_assert(sizeof(float4_t) == 4 * sizeof(float));
 static_assert(sizeof(float8_t) == 8 * sizeof(float));
+static_assert(sizeof(float16_t) == 16 * sizeof(float));
 static_assert(sizeof(float4_unalgn_t) == 4 * sizeof(float));
 static_assert(sizeof(float8_unalgn_t) == 8 * sizeof(float));
+static_assert(sizeof(float16_unalgn_t) == 16 * sizeof(float));
 static_assert(alignof(float4_t) == 4 * sizeof(float));
 static_assert(alignof(float8_t) == 8 * sizeof(float));
+static_assert(alignof(float16_t) == 16 * sizeof(float));
 static_assert(alignof(float4_unalgn_t) == sizeof(float));
 static_assert(alignof(float8_unalgn_t) == sizeof(float));
+static_assert(alignof(float16_unalgn_t) == sizeof(float));
+
+/// the vector types with the given number of floats
+template<int width>
+struct vector_of;
+
+template<>
+struct vector_of<4>
+{
+    using type = float4_t;
+    using unalgn_type = float4_unalgn_t;
+};
+
+template<>
+struct vector_of<8>
+{
+    using type = float8_t;
+    using unalgn_type = float8_unalgn_t;
+};
+
+template<>
+struct vector_of<16>
+{
+    using type = float16_t;
+    using unalgn_type = float16_unalgn_t;
+};
+
+namespace detail {
+
+template<int mask, typename vector_t, std::size_t... lane>
+inline vector_t
+xor_shuffle(vector_t v, std::index_sequence<lane...>)
+{
+    return __builtin_shufflevector(v, v, (lane ^ mask)...);
+}
+
+} // namespace detail
+
+/// permute the lanes of v so that lane i of the result is lane (i ^ mask) of v
+template<int mask, typename vector_t>
+inline vector_t
+xor_shuffle(vector_t v)
+{
+    constexpr std::size_t width = sizeof(vector_t) / sizeof(float);
+    return detail::xor_shuffle<mask>(v, std::make_index_sequence<width>{});
+}
 
-} // namespace cmpe492
\ No newline at end of file
+} // namespace cmpe492
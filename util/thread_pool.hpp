@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace cmpe492 {
+
+/// process-wide pool of persistent worker threads.
+/// the pool size counts the calling thread too, so a pool of size n keeps n - 1 workers.
+/// the initial size is read from the CMPE492_NUM_THREADS environment variable and defaults
+/// to the number of hardware threads.
+/// idle workers spin for a while waiting for the next job and then park on a condition variable.
+class thread_pool
+{
+    using job_fn_t = void (*)(void*, int);
+
+    static constexpr int spin_limit = 1 << 10;  // busy-wait iterations before yielding
+    static constexpr int yield_limit = 1 << 12; // iterations before an idle worker parks
+
+    std::vector<std::thread> workers_;
+
+    std::mutex submit_mtx_; // serializes parallel_for calls and resizing
+    std::mutex park_mtx_;
+    std::condition_variable park_cv_;
+
+    std::atomic<unsigned> generation_{ 0 }; // incremented for each job
+    std::atomic<int> busy_{ 0 };            // workers that have not finished the current job
+    std::atomic<bool> stop_{ false };
+
+    job_fn_t job_fn_ = nullptr;
+    void* job_ctx_ = nullptr;
+    int job_end_ = 0;
+    std::atomic<int> job_next_{ 0 };
+
+    /// true on the workers, and on the thread that submitted the current job while it runs
+    /// tasks of it, so that a parallel_for inside a task runs inline
+    static bool& in_job()
+    {
+        static thread_local bool flag = false;
+        return flag;
+    }
+
+    static void pause()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    static int default_size()
+    {
+        if (char const* env = std::getenv("CMPE492_NUM_THREADS")) {
+            int n = std::atoi(env);
+            if (n > 0) {
+                return n;
+            }
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    thread_pool() { start(default_size()); }
+
+    ~thread_pool() { stop(); }
+
+    void start(int n)
+    {
+        stop_ = false;
+        const unsigned seen = generation_.load();
+        for (int i = 1; i < n; i++) {
+            workers_.emplace_back([this, seen] { worker_loop(seen); });
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(park_mtx_);
+            stop_ = true;
+            generation_.fetch_add(1, std::memory_order_release);
+        }
+        park_cv_.notify_all();
+
+        for (auto& w : workers_) {
+            w.join();
+        }
+        workers_.clear();
+    }
+
+    void run_job()
+    {
+        for (int i = job_next_.fetch_add(1); i < job_end_; i = job_next_.fetch_add(1)) {
+            job_fn_(job_ctx_, i);
+        }
+    }
+
+    void worker_loop(unsigned seen)
+    {
+        in_job() = true;
+
+        while (true) {
+            for (int spins = 0; generation_.load(std::memory_order_acquire) == seen; spins++) {
+                if (spins < spin_limit) {
+                    pause();
+                } else if (spins < yield_limit) {
+                    std::this_thread::yield();
+                } else {
+                    std::unique_lock<std::mutex> lk(park_mtx_);
+                    park_cv_.wait(lk, [&] { return generation_.load() != seen; });
+                }
+            }
+            seen = generation_.load(std::memory_order_acquire);
+
+            if (stop_) {
+                return;
+            }
+
+            run_job();
+            busy_.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void run(int begin, int end, job_fn_t fn, void* ctx)
+    {
+        if (end - begin <= 0) {
+            return;
+        }
+
+        // nested calls and single-task jobs are run inline by the calling thread, and so are the
+        // jobs submitted while another thread's job is running
+        std::unique_lock<std::mutex> lk(submit_mtx_, std::defer_lock);
+        if (workers_.empty() || end - begin == 1 || in_job() || !lk.try_lock()) {
+            for (int i = begin; i < end; i++) {
+                fn(ctx, i);
+            }
+            return;
+        }
+
+        job_fn_ = fn;
+        job_ctx_ = ctx;
+        job_end_ = end;
+        job_next_ = begin;
+        busy_ = static_cast<int>(workers_.size());
+
+        {
+            std::lock_guard<std::mutex> park_lk(park_mtx_);
+            generation_.fetch_add(1, std::memory_order_release);
+        }
+        park_cv_.notify_all();
+
+        in_job() = true;
+        run_job();
+        in_job() = false;
+
+        for (int spins = 0; busy_.load(std::memory_order_acquire) != 0; spins++) {
+            if (spins < spin_limit) {
+                pause();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+public:
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    static thread_pool& instance()
+    {
+        static thread_pool pool;
+        return pool;
+    }
+
+    /// number of threads that execute a parallel_for, including the caller
+    int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+    /// change the number of threads. must not be called from inside a parallel_for.
+    void resize(int n)
+    {
+        std::lock_guard<std::mutex> lk(submit_mtx_);
+        stop();
+        start(std::max(1, n));
+    }
+
+    /// call func(i) for each i in [begin, end), distributing the indices among the threads.
+    /// returns when all calls have finished.
+    template<typename Func>
+    void parallel_for(int begin, int end, Func&& func)
+    {
+        using func_t = std::remove_reference_t<Func>;
+
+        run(
+          begin,
+          end,
+          [](void* ctx, int i) { (*static_cast<func_t*>(ctx))(i); },
+          const_cast<void*>(static_cast<void const*>(&func)));
+    }
+};
+
+/// number of threads used by the multi-threaded kernels
+inline int
+get_num_threads()
+{
+    return thread_pool::instance().size();
+}
+
+/// set the number of threads used by the multi-threaded kernels
+inline void
+set_num_threads(int n)
+{
+    thread_pool::instance().resize(n);
+}
+
+/// call func(i) for each i in [begin, end) on the process-wide thread pool
+template<typename Func>
+void
+parallel_for(int begin, int end, Func&& func)
+{
+    thread_pool::instance().parallel_for(begin, end, std::forward<Func>(func));
+}
+
+} // namespace cmpe492
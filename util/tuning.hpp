@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace cmpe492 {
+
+/// name of the cpu, the brand string reported by cpuid, or "unknown"
+inline std::string
+cpu_model()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int regs[12] = {};
+
+    if (__get_cpuid_max(0x80000000, nullptr) >= 0x80000004) {
+        for (unsigned int i = 0; i < 3; i++) {
+            unsigned int* r = &regs[4 * i];
+            __get_cpuid(0x80000002 + i, &r[0], &r[1], &r[2], &r[3]);
+        }
+
+        std::string model(reinterpret_cast<char const*>(regs), sizeof(regs));
+        model = model.c_str(); // drop the trailing zeros
+
+        // trim the spaces, the tuning cache separates its fields with tabs
+        const auto first = model.find_first_not_of(' ');
+        const auto last = model.find_last_not_of(' ');
+
+        if (first != std::string::npos) {
+            return model.substr(first, last - first + 1);
+        }
+    }
+#endif
+    return "unknown";
+}
+
+/// the class of a dimension for the tuning cache, two classes per power of two.
+/// the shapes of a class are expected to share their best configuration.
+inline int
+size_class(int n)
+{
+    return n <= 1 ? 0 : static_cast<int>(std::floor(2 * std::log2(n)));
+}
+
+/// configurations found by the autotuner, stored in a text file with one line per entry:
+/// cpu model, kernel name, shape class and parameters, separated by tabs.
+/// the file is CMPE492_TUNING_CACHE if set, otherwise .cmpe492_tuning in the home directory.
+/// only the entries of the cpu this runs on are used.
+class tuning_cache
+{
+public:
+    using shape_t = std::array<int, 3>;
+    using params_t = std::vector<int>;
+
+private:
+    std::string path_;
+    std::string cpu_;
+    std::map<std::pair<std::string, shape_t>, params_t> entries_;
+    mutable std::mutex mtx_;
+    std::atomic<unsigned> version_{ 1 };
+
+    static std::string default_path()
+    {
+        if (char const* env = std::getenv("CMPE492_TUNING_CACHE")) {
+            return env;
+        }
+        if (char const* home = std::getenv("HOME")) {
+            return std::string(home) + "/.cmpe492_tuning";
+        }
+        return ".cmpe492_tuning";
+    }
+
+    tuning_cache()
+      : path_(default_path())
+      , cpu_(cpu_model())
+    {
+        std::ifstream in(path_);
+        std::string line;
+
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string cpu, kernel, shape, params;
+
+            if (!std::getline(fields, cpu, '\t') || !std::getline(fields, kernel, '\t') ||
+                !std::getline(fields, shape, '\t') || !std::getline(fields, params, '\t')) {
+                continue; // not an entry
+            }
+            if (cpu != cpu_) {
+                continue;
+            }
+
+            shape_t s = {};
+            std::istringstream(shape) >> s[0] >> s[1] >> s[2];
+
+            params_t p;
+            std::istringstream ps(params);
+            for (int v; ps >> v;) {
+                p.push_back(v);
+            }
+
+            entries_[{ kernel, s }] = p;
+        }
+    }
+
+public:
+    tuning_cache(tuning_cache const&) = delete;
+    tuning_cache& operator=(tuning_cache const&) = delete;
+
+    /// the cache of the process, read from the file on the first use
+    static tuning_cache& instance()
+    {
+        static tuning_cache cache;
+        return cache;
+    }
+
+    std::string const& path() const { return path_; }
+
+    /// changes whenever an entry is stored, for the kernels that remember what they looked up
+    unsigned version() const { return version_.load(std::memory_order_acquire); }
+
+    /// the parameters of kernel for the shape class, or an empty vector if not tuned yet
+    params_t lookup(std::string const& kernel, shape_t const& shape) const
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+
+        auto it = entries_.find({ kernel, shape });
+        return it == entries_.end() ? params_t{} : it->second;
+    }
+
+    /// record the parameters of kernel for the shape class and append them to the file.
+    /// returns false if the file cannot be written.
+    bool store(std::string const& kernel, shape_t const& shape, params_t const& params)
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+
+        entries_[{ kernel, shape }] = params;
+        version_.fetch_add(1, std::memory_order_release);
+
+        // later lines override earlier ones when the file is read
+        std::ofstream out(path_, std::ios::app);
+
+        out << cpu_ << '\t' << kernel << '\t' << shape[0] << ' ' << shape[1] << ' ' << shape[2]
+            << '\t';
+        for (size_t i = 0; i < params.size(); i++) {
+            out << (i ? " " : "") << params[i];
+        }
+        out << '\n';
+
+        return static_cast<bool>(out);
+    }
+};
+
+} // namespace cmpe492